@@ -0,0 +1,77 @@
+#include "BallRaster.h"
+#include <cmath>
+#include <algorithm>
+
+BallRaster::BallRaster(WorkerPool& pool, int bandH)
+    : pool(pool), bandH(bandH > 0 ? bandH : 16)
+{
+}
+
+void BallRaster::begin(int w, int h)
+{
+    this->w = w;
+    this->h = h;
+    circles.clear();
+    // keep bins capacity between frames
+    bins.resize((h + bandH - 1) / bandH);
+    for (auto& bin : bins)
+    {
+        bin.clear();
+    }
+}
+
+void BallRaster::addCircle(float x, float y, float r, Uint32 color)
+{
+    if (r <= 0.f || x + r < 0.f || x - r >= w || y + r < 0.f || y - r >= h)
+    {
+        return;
+    }
+
+    const int id = (int)circles.size();
+    circles.push_back({ x, y, r, color });
+
+    const int b0 = std::max(0, (int)floorf(y - r) / bandH);
+    const int b1 = std::min((int)bins.size() - 1, (int)floorf(y + r) / bandH);
+    for (int b = b0; b <= b1; ++b)
+    {
+        bins[b].push_back(id);
+    }
+}
+
+void BallRaster::render(Uint32* pixels, int pitch, Uint32 bgColor)
+{
+    pool.parallelFor((int)bins.size(), [&](int band)
+    {
+        renderBand(band, pixels, pitch, bgColor);
+    });
+}
+
+void BallRaster::renderBand(int band, Uint32* pixels, int pitch, Uint32 bgColor) const
+{
+    const int y0 = band * bandH;
+    const int y1 = std::min(y0 + bandH, h);
+    for (int y = y0; y < y1; ++y)
+    {
+        fillSpan32((Uint32*)((Uint8*)pixels + y * pitch), w, bgColor);
+    }
+
+    for (int id : bins[band])
+    {
+        const Circle& c = circles[id];
+        const int cy0 = std::max(y0, (int)ceilf(c.y - c.r - 0.5f));
+        const int cy1 = std::min(y1 - 1, (int)floorf(c.y + c.r - 0.5f));
+        const float rr = c.r * c.r;
+        for (int y = cy0; y <= cy1; ++y)
+        {
+            // pixel centers inside the circle
+            const float dy = y + 0.5f - c.y;
+            const float hw = sqrtf(std::max(rr - dy * dy, 0.f));
+            const int x0 = std::max(0, (int)ceilf(c.x - hw - 0.5f));
+            const int x1 = std::min(w - 1, (int)floorf(c.x + hw - 0.5f));
+            if (x1 >= x0)
+            {
+                fillSpan32((Uint32*)((Uint8*)pixels + y * pitch) + x0, x1 - x0 + 1, c.color);
+            }
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <vector>
+#include "Memake/WorkerPool.h"
+#include "Memake/SpanFill.h"
+
+// Threaded CPU rasterizer of filled circles into a 32-bit framebuffer.
+// The framebuffer is split into horizontal bands, circles are binned by the
+// bands they touch and every band is filled by one worker, so no two threads
+// write the same row.
+class BallRaster
+{
+public:
+    BallRaster(WorkerPool& pool, int bandH = 16);
+
+    // Start new frame of given size, drops circles of previous frame.
+    void begin(int w, int h);
+    void addCircle(float x, float y, float r, Uint32 color);
+    // Fill whole framebuffer: background then circles in submission order.
+    void render(Uint32* pixels, int pitch, Uint32 bgColor);
+
+private:
+    struct Circle
+    {
+        float x, y, r;
+        Uint32 color;
+    };
+
+    void renderBand(int band, Uint32* pixels, int pitch, Uint32 bgColor) const;
+
+    WorkerPool& pool;
+    int bandH;
+    int w = 0;
+    int h = 0;
+    std::vector<Circle> circles;
+    std::vector<std::vector<int>> bins; // circle ids per band
+};
@@ -0,0 +1,291 @@
+#include "ClRaster.h"
+#include "Memake/Layer.h"
+#include "Memake/SpanFill.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+ClRaster::ClRaster(const cl::Context& context, const cl::Device& device, const std::string& kernelSrc)
+    : context(context)
+{
+    cl::Program::Sources sources(1, std::make_pair(kernelSrc.c_str(), kernelSrc.length() + 1));
+    cl::Program program(context, sources);
+    auto err = program.build();
+    if (err != CL_BUILD_SUCCESS)
+    {
+        std::cerr << "Error!\nBuild Status: " << program.getBuildInfo<CL_PROGRAM_BUILD_STATUS>(device)
+            << "\nBuild Log:\t " << program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device) << std::endl;
+        return;
+    }
+    kernel = cl::Kernel(program, "rasterTiles");
+    queue = cl::CommandQueue(context, device);
+    ready = true;
+}
+
+void ClRaster::resize(int width, int height)
+{
+    w = std::max(width, 0);
+    h = std::max(height, 0);
+    pixels.assign((size_t)w * h, 0xFF000000);
+    tilesX = (w + k_tileSize - 1) / k_tileSize;
+    tilesY = (h + k_tileSize - 1) / k_tileSize;
+    if (ready && w > 0 && h > 0)
+    {
+        pixelBuf = cl::Buffer(context, CL_MEM_READ_WRITE, pixels.size() * sizeof(Uint32));
+    }
+    hostWritten = true;
+}
+
+Uint32* ClRaster::getPixels()
+{
+    // the device copy is stale once the user writes
+    hostWritten = true;
+    return pixels.data();
+}
+
+void ClRaster::addPrim(PrimType type, Uint32 color, int x1, int y1, int x2, int y2, int p0, int p1, SDL_Rect bounds)
+{
+    const SDL_Rect screen = { 0, 0, w, h };
+    if (!SDL_IntersectRect(&bounds, &screen, &bounds))
+    {
+        return;
+    }
+    prims.push_back({ (cl_int)type, (cl_uint)color, x1, y1, x2, y2, p0, p1 });
+    this->bounds.push_back(bounds);
+}
+
+void ClRaster::addRect(Uint32 color, const SDL_Rect& r)
+{
+    addPrim(Rect, color, r.x, r.y, r.w, r.h, 0, 0, r);
+}
+
+int ClRaster::ellipseTable(int rx, int ry)
+{
+    // half widths of rows -ry..ry, -1 for rows without pixels
+    const Uint64 key = ((Uint64)(Uint32)rx << 32) | (Uint32)ry;
+    auto it = tables.find(key);
+    if (it != tables.end())
+    {
+        return it->second;
+    }
+    const int offset = (int)extra.size();
+    extra.resize(extra.size() + 2 * ry + 1, -1);
+    rects.clear();
+    filledEllipseSpans(0, 0, rx, ry, rects);
+    for (const SDL_Rect& r : rects)
+    {
+        for (int y = r.y; y < r.y + r.h; ++y)
+        {
+            extra[offset + y + ry] = std::max(extra[offset + y + ry], (cl_int)-r.x);
+        }
+    }
+    tables[key] = offset;
+    return offset;
+}
+
+void ClRaster::gather(const DrawList& list, FractalTreeCache* treeCache)
+{
+    for (const DrawCmd& cmd : list.getCmds())
+    {
+        const Uint32 color = packARGB(cmd.color);
+        switch (cmd.type)
+        {
+        case DrawCmdType::Rect:
+            addRect(color, { cmd.x1, cmd.y1, cmd.x2, cmd.y2 });
+            break;
+        case DrawCmdType::Dot:
+            addRect(color, { cmd.x1, cmd.y1, 1, 1 });
+            break;
+        case DrawCmdType::Ellipse:
+            if (cmd.x2 >= 0 && cmd.y2 >= 0)
+            {
+                addPrim(Ellipse, color, cmd.x1, cmd.y1, cmd.x2, cmd.y2, ellipseTable(cmd.x2, cmd.y2), 0,
+                    { cmd.x1 - cmd.x2, cmd.y1 - cmd.y2, 2 * cmd.x2 + 1, 2 * cmd.y2 + 1 });
+            }
+            break;
+        case DrawCmdType::Polygon:
+        {
+            const int* vx = list.getVx() + cmd.x1;
+            const int* vy = list.getVy() + cmd.x1;
+            const int n = cmd.x2;
+            if (n < 3)
+            {
+                break;
+            }
+            int x0 = vx[0], y0 = vy[0], x1 = vx[0], y1 = vy[0];
+            const int offset = (int)extra.size();
+            for (int i = 0; i < n; ++i)
+            {
+                x0 = std::min(x0, vx[i]);
+                y0 = std::min(y0, vy[i]);
+                x1 = std::max(x1, vx[i]);
+                y1 = std::max(y1, vy[i]);
+                extra.push_back(vx[i]);
+                extra.push_back(vy[i]);
+            }
+            // spans are rounded to pixels, give them one pixel on both sides
+            addPrim(Polygon, color, x0 - 1, y0, x1 + 1, y1, offset, n, { x0 - 1, y0, x1 - x0 + 3, y1 - y0 + 1 });
+            break;
+        }
+        case DrawCmdType::Line:
+            rects.clear();
+            lineRuns(cmd.x1, cmd.y1, cmd.x2, cmd.y2, true, rects);
+            for (const SDL_Rect& r : rects)
+            {
+                addRect(color, r);
+            }
+            break;
+        case DrawCmdType::EllipseBorder:
+            // closed polyline, every segment without its end so no pixel is drawn twice
+            points.clear();
+            rects.clear();
+            borderEllipsePoints(cmd.x1, cmd.y1, cmd.x2, cmd.y2, points);
+            for (size_t i = 0; i + 1 < points.size(); ++i)
+            {
+                lineRuns(points[i].x, points[i].y, points[i + 1].x, points[i + 1].y, false, rects);
+            }
+            for (const SDL_Rect& r : rects)
+            {
+                addRect(color, r);
+            }
+            break;
+        case DrawCmdType::AALine:
+        case DrawCmdType::FractalTree:
+        {
+            // anti-aliased points are single pixel rects with their own alpha
+            const AALineBatch* batch = &aaLine;
+            aaLine.clear();
+            if (cmd.type == DrawCmdType::AALine)
+            {
+                aaLine.addLine(cmd.x1, cmd.y1, cmd.x2, cmd.y2);
+            }
+            else if (treeCache != NULL)
+            {
+                batch = &treeCache->getPoints({ cmd.x1, cmd.y1, cmd.x2, cmd.y2, cmd.x3, cmd.y3 });
+            }
+            else
+            {
+                RenderTreeLines(aaLine, cmd.x1, cmd.y1, cmd.x2, cmd.y2, cmd.x3, cmd.y3);
+            }
+            batch->forEachPoint([&](const SDL_Point& p, int level) {
+                const Uint32 alpha = AALineBatch::levelAlpha(level, cmd.color.a);
+                addRect((color & 0x00FFFFFF) | (alpha << 24), { p.x, p.y, 1, 1 });
+            });
+            break;
+        }
+        case DrawCmdType::Polkadot:
+            if (cmd.x2 > cmd.x1 && cmd.y2 > cmd.y1)
+            {
+                addPrim(Polkadot, color, cmd.x1, cmd.y1, cmd.x2, cmd.y2, 0, 0,
+                    { cmd.x1, cmd.y1, cmd.x2 - cmd.x1, cmd.y2 - cmd.y1 });
+            }
+            break;
+        case DrawCmdType::Layer:
+            // layer content is drawn where the layer is
+            gather(*list.getLayers()[cmd.x1].list, treeCache);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void ClRaster::buildFrame()
+{
+    // primitives, extra section, tile offsets, primitive ids per tile
+    const int primInts = (int)(prims.size() * sizeof(Prim) / sizeof(cl_int));
+    const int tileCnt = tilesX * tilesY;
+    const int tileOffsets = primInts + (int)extra.size();
+    const int tileIds = tileOffsets + tileCnt + 1;
+
+    frame.assign(tileIds, 0);
+    for (size_t i = 0; i < prims.size(); ++i)
+    {
+        // tables and vertices are addressed from the frame start
+        Prim& p = prims[i];
+        if (p.type == Ellipse || p.type == Polygon)
+        {
+            p.p0 += primInts;
+        }
+        const SDL_Rect& b = bounds[i];
+        for (int ty = b.y / k_tileSize; ty <= (b.y + b.h - 1) / k_tileSize; ++ty)
+        {
+            for (int tx = b.x / k_tileSize; tx <= (b.x + b.w - 1) / k_tileSize; ++tx)
+            {
+                ++frame[tileOffsets + ty * tilesX + tx + 1];
+            }
+        }
+    }
+    memcpy(frame.data(), prims.data(), prims.size() * sizeof(Prim));
+    std::copy(extra.begin(), extra.end(), frame.begin() + primInts);
+    for (int t = 0; t < tileCnt; ++t)
+    {
+        frame[tileOffsets + t + 1] += frame[tileOffsets + t];
+    }
+
+    // ids in submission order, the offsets serve as fill positions and end up shifted by one tile
+    frame.resize(tileIds + frame[tileOffsets + tileCnt]);
+    for (size_t i = 0; i < prims.size(); ++i)
+    {
+        const SDL_Rect& b = bounds[i];
+        for (int ty = b.y / k_tileSize; ty <= (b.y + b.h - 1) / k_tileSize; ++ty)
+        {
+            for (int tx = b.x / k_tileSize; tx <= (b.x + b.w - 1) / k_tileSize; ++tx)
+            {
+                frame[tileIds + frame[tileOffsets + ty * tilesX + tx]++] = (cl_int)i;
+            }
+        }
+    }
+    for (int t = tileCnt; t > 0; --t)
+    {
+        frame[tileOffsets + t] = frame[tileOffsets + t - 1];
+    }
+    frame[tileOffsets] = 0;
+}
+
+void ClRaster::render(const DrawList& list, const Color* clearColor)
+{
+    if (!ready || w == 0 || h == 0)
+    {
+        return;
+    }
+
+    prims.clear();
+    bounds.clear();
+    extra.clear();
+    tables.clear();
+    gather(list, list.getFractalTreeCache());
+    buildFrame();
+
+    // whole frame goes up in one write, the buffer only grows
+    const size_t frameSize = frame.size() * sizeof(cl_int);
+    if (frameSize > frameBufSize)
+    {
+        frameBufSize = std::max(frameSize, 2 * frameBufSize);
+        frameBuf = cl::Buffer(context, CL_MEM_READ_ONLY, frameBufSize);
+    }
+    queue.enqueueWriteBuffer(frameBuf, CL_FALSE, 0, frameSize, frame.data());
+    if (clearColor == NULL && hostWritten)
+    {
+        queue.enqueueWriteBuffer(pixelBuf, CL_FALSE, 0, pixels.size() * sizeof(Uint32), pixels.data());
+    }
+
+    const int primInts = (int)(prims.size() * sizeof(Prim) / sizeof(cl_int));
+    const int tileOffsets = primInts + (int)extra.size();
+    const Uint32 bg = clearColor != NULL ? packARGB({ clearColor->r, clearColor->g, clearColor->b, 0xFF }) : 0;
+    kernel.setArg(0, frameBuf);
+    kernel.setArg(1, tileOffsets);
+    kernel.setArg(2, tileOffsets + tilesX * tilesY + 1);
+    kernel.setArg(3, tilesX);
+    kernel.setArg(4, w);
+    kernel.setArg(5, h);
+    kernel.setArg(6, clearColor != NULL ? 1 : 0);
+    kernel.setArg(7, (cl_uint)bg);
+    kernel.setArg(8, pixelBuf);
+    queue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(tilesX * k_tileSize, tilesY * k_tileSize),
+        cl::NDRange(k_tileSize, k_tileSize));
+
+    // blocking read on the in-order queue, frame and pixels may be touched again afterwards
+    queue.enqueueReadBuffer(pixelBuf, CL_TRUE, 0, pixels.size() * sizeof(Uint32), pixels.data());
+    hostWritten = false;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#ifdef GPU_VENDOR_IS_AMD
+#define CL_HPP_ENABLE_PROGRAM_CONSTRUCTION_FROM_ARRAY_COMPATIBILITY
+#include <CL/cl2.hpp>
+#endif // GPU_VENDOR_IS_AMD
+
+#ifdef GPU_VENDOR_IS_NVIDIA
+#include <CL/cl.hpp>
+#endif // GPU_VENDOR_IS_NVIDIA
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "Memake/DrawList.h"
+#include "Memake/Rasterizer.h"
+
+// OpenCL rasterizer of Memake draw lists, kernels in raster.cl.
+// All primitives of a frame, their vertices and the per tile primitive lists
+// go to the device in one buffer. One work-group draws a tile of the pixel
+// buffer, every work-item one pixel, going through the tile's primitives in
+// submission order. The pixels are then read back for SDL_UpdateTexture.
+// Filled ellipses and polygons cover the same pixels as Memake's span fills,
+// lines, borders and anti-aliased points are converted to rects on the host.
+class ClRaster : public Rasterizer
+{
+public:
+    static const int k_tileSize = 16; // work-group is k_tileSize x k_tileSize
+
+    ClRaster(const cl::Context& context, const cl::Device& device, const std::string& kernelSrc);
+
+    // False if the kernel didn't build, the error is printed then.
+    bool isReady() const { return ready; }
+
+    void resize(int width, int height) override;
+    Uint32* getPixels() override;
+    const Uint32* getPixels() const override { return pixels.data(); }
+    int getPitch() const override { return w * (int)sizeof(Uint32); }
+    void render(const DrawList& list, const Color* clearColor = NULL) override;
+
+private:
+    enum PrimType
+    {
+        Rect = 0,     // (x1, y1) position, (x2, y2) size
+        Ellipse = 1,  // (x1, y1) center, (x2, y2) radii, p0 half width table, one row per line
+        Polygon = 2,  // (x1, y1) - (x2, y2) bounds, p0 vertices as x, y pairs, p1 vertex count
+        Polkadot = 3, // (x1, y1) - (x2, y2) region
+    };
+
+    // Layout of a primitive in the frame buffer, 8 ints.
+    struct Prim
+    {
+        cl_int type;
+        cl_uint color;
+        cl_int x1, y1, x2, y2;
+        cl_int p0, p1;
+    };
+
+    void gather(const DrawList& list, FractalTreeCache* treeCache);
+    void addPrim(PrimType type, Uint32 color, int x1, int y1, int x2, int y2, int p0, int p1, SDL_Rect bounds);
+    void addRect(Uint32 color, const SDL_Rect& r);
+    int ellipseTable(int rx, int ry);
+    void buildFrame();
+
+    bool ready = false;
+    cl::Context context;
+    cl::CommandQueue queue;
+    cl::Kernel kernel;
+    cl::Buffer frameBuf;
+    size_t frameBufSize = 0;
+    cl::Buffer pixelBuf;
+
+    int w = 0;
+    int h = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+    std::vector<Uint32> pixels;
+    bool hostWritten = false; // pixels handed out for writing since the last read back
+
+    // frame, kept between frames to avoid allocations
+    std::vector<Prim> prims;
+    std::vector<SDL_Rect> bounds;
+    std::vector<cl_int> extra;             // vertices and ellipse tables
+    std::unordered_map<Uint64, int> tables; // (rx, ry) -> offset in extra
+    std::vector<cl_int> frame;
+    std::vector<SDL_Rect> rects;
+    std::vector<SDL_Point> points;
+    AALineBatch aaLine;
+};
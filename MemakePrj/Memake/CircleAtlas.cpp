@@ -0,0 +1,167 @@
+#include "CircleAtlas.h"
+#include "Utils.h"
+
+CircleAtlas::~CircleAtlas()
+{
+    release();
+}
+
+void CircleAtlas::release()
+{
+    if (texture != NULL)
+    {
+        SDL_DestroyTexture(texture);
+    }
+    texture = NULL;
+    owner = NULL;
+    sprites.clear();
+    shelfX = shelfY = shelfH = 0;
+}
+
+void CircleAtlas::rasterize(int radius, bool antialias, int size)
+{
+    pixels.assign(size * size, 0x00FFFFFF);
+
+    if (!antialias)
+    {
+        // same rows as filledEllipseRGBA, so sprite and span drawing match, radius 0 is a single pixel
+        for (const SDL_Point &o : ellipseSpanOffsets(radius, radius))
+        {
+            Uint32 *row = &pixels[(radius + o.y) * size];
+            for (int x = radius - o.x; x <= radius + o.x; ++x)
+            {
+                row[x] = 0xFFFFFFFF;
+            }
+        }
+        return;
+    }
+
+    // 4x4 supersampled coverage of circle with radius + 0.5 around the center pixel
+    const float c = radius + 0.5f;
+    const float rr = c * c;
+    for (int y = 0; y < size; ++y)
+    {
+        for (int x = 0; x < size; ++x)
+        {
+            int inside = 0;
+            for (int sy = 0; sy < 4; ++sy)
+            {
+                const float dy = y + (sy + 0.5f) / 4.f - c;
+                for (int sx = 0; sx < 4; ++sx)
+                {
+                    const float dx = x + (sx + 0.5f) / 4.f - c;
+                    inside += (dx * dx + dy * dy) <= rr;
+                }
+            }
+            const Uint32 alpha = (Uint32)(inside * 255 / 16);
+            pixels[y * size + x] = (alpha << 24) | 0x00FFFFFF;
+        }
+    }
+}
+
+bool CircleAtlas::addSprite(SDL_Renderer *renderer, int radius, bool antialias, SDL_Rect &src)
+{
+    const int size = 2 * radius + 1;
+
+    if (texture == NULL || owner != renderer)
+    {
+        release();
+        texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, atlasSize, atlasSize);
+        if (texture == NULL)
+        {
+            return false;
+        }
+        setTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+        owner = renderer;
+    }
+
+    // next shelf, or start over when the atlas is full
+    if (shelfX + size > atlasSize)
+    {
+        shelfX = 0;
+        shelfY += shelfH;
+        shelfH = 0;
+    }
+    if (shelfY + size > atlasSize)
+    {
+        sprites.clear();
+        shelfX = shelfY = shelfH = 0;
+    }
+
+    src = {shelfX, shelfY, size, size};
+    shelfX += size;
+    shelfH = SDL_max(shelfH, size);
+
+    rasterize(radius, antialias, size);
+    updateTexture(texture, &src, pixels.data(), size * sizeof(Uint32));
+    sprites[radius * 2 + (antialias ? 1 : 0)] = src;
+    return true;
+}
+
+bool CircleAtlas::prepare(SDL_Renderer *renderer, int radius, bool antialias, Color color, SDL_Rect &src)
+{
+    if (radius < 0 || radius > k_maxRadius)
+    {
+        return false;
+    }
+
+    auto it = owner == renderer ? sprites.find(radius * 2 + (antialias ? 1 : 0)) : sprites.end();
+    if (it != sprites.end())
+    {
+        src = it->second;
+    }
+    else if (!addSprite(renderer, radius, antialias, src))
+    {
+        return false;
+    }
+
+    setTextureColorMod(texture, color.r, color.g, color.b);
+    setTextureAlphaMod(texture, color.a);
+    return true;
+}
+
+bool CircleAtlas::draw(SDL_Renderer *renderer, int x, int y, int radius, bool antialias, Color color)
+{
+    SDL_Rect src;
+    if (!prepare(renderer, radius, antialias, color, src))
+    {
+        return false;
+    }
+    SDL_Rect dst = {x - radius, y - radius, src.w, src.h};
+    renderCopy(renderer, texture, &src, &dst);
+    return true;
+}
+
+bool CircleAtlas::drawMany(SDL_Renderer *renderer, const SDL_Point *centers, int count, int radius, bool antialias, Color color)
+{
+    SDL_Rect src;
+    if (!prepare(renderer, radius, antialias, color, src))
+    {
+        return false;
+    }
+    SDL_Rect dst = {0, 0, src.w, src.h};
+    for (int i = 0; i < count; ++i)
+    {
+        dst.x = centers[i].x - radius;
+        dst.y = centers[i].y - radius;
+        renderCopy(renderer, texture, &src, &dst);
+    }
+    return true;
+}
+
+bool CircleAtlas::drawMany(SDL_Renderer *renderer, const Vector2 *centers, int count, int radius, bool antialias, Color color)
+{
+    SDL_Rect src;
+    if (!prepare(renderer, radius, antialias, color, src))
+    {
+        return false;
+    }
+    SDL_Rect dst = {0, 0, src.w, src.h};
+    for (int i = 0; i < count; ++i)
+    {
+        dst.x = (int)centers[i].x - radius;
+        dst.y = (int)centers[i].y - radius;
+        renderCopy(renderer, texture, &src, &dst);
+    }
+    return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <SDL.h>
+
+#include "Colmake.h"
+#include "Vector2d.h"
+
+/**
+ * Texture atlas of white circles with coverage in alpha.
+ * Every (radius, antialias) circle is rasterized once on first use, drawing is then
+ * a color modulated SDL_RenderCopy which accelerated renderers batch into quads.
+ */
+class CircleAtlas
+{
+public:
+    static const int k_maxRadius = 128;
+
+    ~CircleAtlas();
+
+    /**
+     * Drop texture and sprites, must be called before the renderer is destroyed.
+     */
+    void release();
+
+    /**
+     * Draw circle centered at (x, y), returns false if radius isn't supported by the atlas.
+     */
+    bool draw(SDL_Renderer *renderer, int x, int y, int radius, bool antialias, Color color);
+
+    /**
+     * Draw same size circles at every center, returns false if radius isn't supported by the atlas.
+     */
+    bool drawMany(SDL_Renderer *renderer, const SDL_Point *centers, int count, int radius, bool antialias, Color color);
+    bool drawMany(SDL_Renderer *renderer, const Vector2 *centers, int count, int radius, bool antialias, Color color);
+
+private:
+    bool prepare(SDL_Renderer *renderer, int radius, bool antialias, Color color, SDL_Rect &src);
+    bool addSprite(SDL_Renderer *renderer, int radius, bool antialias, SDL_Rect &src);
+    void rasterize(int radius, bool antialias, int size);
+
+    SDL_Texture *texture = NULL;
+    SDL_Renderer *owner = NULL;
+    int atlasSize = 1024;
+
+    // shelf packing: sprites are put left to right in rows of the tallest sprite height
+    int shelfX = 0;
+    int shelfY = 0;
+    int shelfH = 0;
+
+    std::unordered_map<int, SDL_Rect> sprites; // key: radius * 2 + antialias
+    std::vector<Uint32> pixels;                 // rasterization scratch
+};
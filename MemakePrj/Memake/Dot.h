@@ -14,8 +14,8 @@ public:
 
     void Draw(SDL_Renderer *renderer, Color color)
     {
-        SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, 255);
-        SDL_RenderDrawPoint(renderer, x, y);
+        setRenderDrawColor(renderer, color.r, color.g, color.b, 255);
+        renderDrawPoint(renderer, x, y);
     }
 
     int x;
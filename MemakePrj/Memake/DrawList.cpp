@@ -0,0 +1,348 @@
+#include "DrawList.h"
+#include "Memake.h"
+#include "Layer.h"
+#include <algorithm>
+
+// Color and blend mode a command is drawn with, Polkadot and Layer color every pixel themselves.
+static Uint64 stateKey(const DrawCmd &cmd)
+{
+    if (cmd.type == DrawCmdType::Polkadot || cmd.type == DrawCmdType::Layer)
+    {
+        return ~0ull;
+    }
+    const Color &c = cmd.color;
+    const Uint64 blend = c.a != 255 ? 1 : 0;
+    return (blend << 32) | ((Uint32)c.r << 24) | ((Uint32)c.g << 16) | ((Uint32)c.b << 8) | c.a;
+}
+
+bool DrawList::isVisible(const DrawCmd &cmd, const SDL_Rect &clip)
+{
+    switch (cmd.type)
+    {
+    case DrawCmdType::Rect:
+        return boundsVisible(SDL_min(cmd.x1, cmd.x1 + cmd.x2), SDL_min(cmd.y1, cmd.y1 + cmd.y2),
+                             SDL_max(cmd.x1, cmd.x1 + cmd.x2), SDL_max(cmd.y1, cmd.y1 + cmd.y2), clip);
+    case DrawCmdType::Ellipse:
+    case DrawCmdType::EllipseBorder:
+        return boundsVisible(cmd.x1 - cmd.x2, cmd.y1 - cmd.y2, cmd.x1 + cmd.x2, cmd.y1 + cmd.y2, clip);
+    case DrawCmdType::Line:
+        return boundsVisible(SDL_min(cmd.x1, cmd.x2), SDL_min(cmd.y1, cmd.y2), SDL_max(cmd.x1, cmd.x2),
+                             SDL_max(cmd.y1, cmd.y2), clip);
+    case DrawCmdType::AALine:
+        // coverage spills one pixel to the sides
+        return boundsVisible(SDL_min(cmd.x1, cmd.x2) - 1, SDL_min(cmd.y1, cmd.y2) - 1, SDL_max(cmd.x1, cmd.x2) + 1,
+                             SDL_max(cmd.y1, cmd.y2) + 1, clip);
+    case DrawCmdType::Dot:
+        return boundsVisible(cmd.x1, cmd.y1, cmd.x1, cmd.y1, clip);
+    default:
+        return true;
+    }
+}
+
+void DrawList::clear()
+{
+    cmds.clear();
+    vx.clear();
+    vy.clear();
+    layers.clear();
+}
+
+void DrawList::add(DrawCmdType type, Color color, int x1, int y1, int x2, int y2, int x3, int y3)
+{
+    cmds.push_back({type, color, x1, y1, x2, y2, x3, y3});
+}
+
+void DrawList::addRect(int x, int y, int width, int height, Color color)
+{
+    add(DrawCmdType::Rect, color, x, y, width, height);
+}
+
+void DrawList::addEllipse(int x, int y, int rx, int ry, Color color)
+{
+    add(DrawCmdType::Ellipse, color, x, y, rx, ry);
+}
+
+void DrawList::addEllipseBorder(int x, int y, int rx, int ry, Color color)
+{
+    // outline is always opaque, record it so with the state it's drawn with
+    add(DrawCmdType::EllipseBorder, {color.r, color.g, color.b, 255}, x, y, rx, ry);
+}
+
+void DrawList::addLine(int x1, int y1, int x2, int y2, Color color)
+{
+    add(DrawCmdType::Line, color, x1, y1, x2, y2);
+}
+
+void DrawList::addAALine(int x1, int y1, int x2, int y2, Color color)
+{
+    add(DrawCmdType::AALine, color, x1, y1, x2, y2);
+}
+
+void DrawList::addDot(int x, int y, Color color)
+{
+    add(DrawCmdType::Dot, color, x, y);
+}
+
+void DrawList::addPolygon(const int *px, const int *py, int numOfEdges, Color color)
+{
+    add(DrawCmdType::Polygon, color, (int)vx.size(), 0, numOfEdges);
+    vx.insert(vx.end(), px, px + numOfEdges);
+    vy.insert(vy.end(), py, py + numOfEdges);
+}
+
+void DrawList::addPolygon(const Vector2 *edgesPos, int numOfEdges, Color color)
+{
+    add(DrawCmdType::Polygon, color, (int)vx.size(), 0, numOfEdges);
+    for (int i = 0; i < numOfEdges; i++)
+    {
+        vx.push_back(edgesPos[i].x);
+        vy.push_back(edgesPos[i].y);
+    }
+}
+
+void DrawList::addPolkadot(int x1, int y1, int x2, int y2)
+{
+    add(DrawCmdType::Polkadot, Colmake.white, x1, y1, x2, y2);
+}
+
+void DrawList::addFractalTree(int x, int y, int lineLength, int lineLengthSeed, int angle, int angleSeed, Color color)
+{
+    add(DrawCmdType::FractalTree, color, x, y, lineLength, lineLengthSeed, angle, angleSeed);
+}
+
+void DrawList::addLayer(Layer *layer, int recording)
+{
+    add(DrawCmdType::Layer, Colmake.white, (int)layers.size(), 0);
+    layers.push_back({layer, &layer->getList(recording), layer->getSerial(recording)});
+}
+
+void DrawList::reserve(size_t n)
+{
+    // keep geometric growth when called with small batches
+    if (cmds.capacity() < cmds.size() + n)
+    {
+        cmds.reserve(std::max(cmds.size() + n, 2 * cmds.capacity()));
+    }
+}
+
+void DrawList::addCircles(const float *x, const float *y, const float *r, const Color *colors, size_t n)
+{
+    reserve(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const int radius = (int)r[i];
+        add(DrawCmdType::Ellipse, colors[i], (int)x[i], (int)y[i], radius, radius);
+    }
+}
+
+void DrawList::addLines(const float *x1, const float *y1, const float *x2, const float *y2, const Color *colors, size_t n,
+                        bool antialias)
+{
+    const DrawCmdType type = antialias ? DrawCmdType::AALine : DrawCmdType::Line;
+    reserve(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        add(type, colors[i], (int)x1[i], (int)y1[i], (int)x2[i], (int)y2[i]);
+    }
+}
+
+void DrawList::addRects(const float *x, const float *y, const float *width, const float *height, const Color *colors,
+                        size_t n)
+{
+    reserve(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        add(DrawCmdType::Rect, colors[i], (int)x[i], (int)y[i], (int)width[i], (int)height[i]);
+    }
+}
+
+void DrawList::addDots(const float *x, const float *y, const Color *colors, size_t n)
+{
+    reserve(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        add(DrawCmdType::Dot, colors[i], (int)x[i], (int)y[i]);
+    }
+}
+
+void DrawList::flushBatches(SDL_Renderer *renderer, Color color)
+{
+    if (!rects.empty())
+    {
+        renderFillRects(renderer, rects.data(), (int)rects.size());
+        rects.clear();
+    }
+    if (!points.empty())
+    {
+        renderDrawPoints(renderer, points.data(), (int)points.size());
+        points.clear();
+    }
+    for (size_t i = 0; i < lineChains.size(); ++i)
+    {
+        const int first = lineChains[i];
+        const int last = i + 1 < lineChains.size() ? lineChains[i + 1] : (int)linePoints.size();
+        renderDrawLines(renderer, &linePoints[first], last - first);
+    }
+    linePoints.clear();
+    lineChains.clear();
+
+    // sets blend mode and per level alpha itself, so it goes last
+    aaLines.flush(renderer, color);
+}
+
+void DrawList::flush(SDL_Renderer *renderer, bool sortByState)
+{
+    order.resize(cmds.size());
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        order[i] = (int)i;
+    }
+    if (sortByState)
+    {
+        // a layer covers what was drawn before it, so it's a segment of its own
+        segments.resize(cmds.size());
+        Uint32 segment = 0;
+        for (size_t i = 0; i < cmds.size(); ++i)
+        {
+            const bool layer = cmds[i].type == DrawCmdType::Layer;
+            segment += layer ? 1 : 0;
+            segments[i] = segment;
+            segment += layer ? 1 : 0;
+        }
+        std::stable_sort(order.begin(), order.end(), [this](int a, int b)
+        {
+            return segments[a] != segments[b] ? segments[a] < segments[b] : stateKey(cmds[a]) < stateKey(cmds[b]);
+        });
+    }
+
+    // what's outside can't show, so it's rejected or cut before it's turned into geometry
+    const SDL_Rect clip = renderClipRect(renderer);
+
+    size_t runBeg = 0;
+    while (runBeg < order.size())
+    {
+        // run of commands drawn with the same state
+        const Uint64 key = stateKey(cmds[order[runBeg]]);
+        size_t runEnd = runBeg + 1;
+        while (runEnd < order.size() && stateKey(cmds[order[runEnd]]) == key)
+        {
+            ++runEnd;
+        }
+
+        const Color color = cmds[order[runBeg]].color;
+        bool stateSet = false;
+        for (size_t k = runBeg; k < runEnd; ++k)
+        {
+            const DrawCmd &cmd = cmds[order[k]];
+            if (!isVisible(cmd, clip))
+            {
+                continue;
+            }
+            switch (cmd.type)
+            {
+            case DrawCmdType::Rect:
+                rects.push_back({cmd.x1, cmd.y1, cmd.x2, cmd.y2});
+                break;
+            case DrawCmdType::Ellipse:
+                // sprites use texture color mod, not draw color, and same color shapes may be drawn in any order
+                if (cmd.x2 != cmd.y2 || circleAtlas == NULL ||
+                    !circleAtlas->draw(renderer, cmd.x1, cmd.y1, cmd.x2, circleAntialias, cmd.color))
+                {
+                    filledEllipseSpans(cmd.x1, cmd.y1, cmd.x2, cmd.y2, rects, &clip);
+                }
+                break;
+            case DrawCmdType::Polygon:
+                filledPolygonSpans(&vx[cmd.x1], &vy[cmd.x1], cmd.x2, rects, &clip);
+                break;
+            case DrawCmdType::Dot:
+                points.push_back({cmd.x1, cmd.y1});
+                break;
+            case DrawCmdType::Line:
+                // connected segments continue the previous polyline
+                if (linePoints.empty() || linePoints.back().x != cmd.x1 || linePoints.back().y != cmd.y1)
+                {
+                    lineChains.push_back((int)linePoints.size());
+                    linePoints.push_back({cmd.x1, cmd.y1});
+                }
+                linePoints.push_back({cmd.x2, cmd.y2});
+                break;
+            case DrawCmdType::EllipseBorder:
+                // closed outline is a polyline of its own
+                lineChains.push_back((int)linePoints.size());
+                borderEllipsePoints(cmd.x1, cmd.y1, cmd.x2, cmd.y2, linePoints);
+                break;
+            case DrawCmdType::AALine:
+                aaLines.addLine(cmd.x1, cmd.y1, cmd.x2, cmd.y2);
+                break;
+            case DrawCmdType::FractalTree:
+                if (treeCache == NULL)
+                {
+                    RenderTreeLines(aaLines, cmd.x1, cmd.y1, cmd.x2, cmd.y2, cmd.x3, cmd.y3);
+                }
+                else if (treeCache->usesTextures())
+                {
+                    // texture color mod is its own state, same color shapes may be drawn in any order
+                    treeCache->draw(renderer, {cmd.x1, cmd.y1, cmd.x2, cmd.y2, cmd.x3, cmd.y3}, cmd.color);
+                }
+                else
+                {
+                    aaLines.append(treeCache->getPoints({cmd.x1, cmd.y1, cmd.x2, cmd.y2, cmd.x3, cmd.y3}));
+                }
+                break;
+            default:
+                // shapes which set renderer state themselves, keep order with already batched geometry
+                if (stateSet)
+                {
+                    flushBatches(renderer, color);
+                }
+                switch (cmd.type)
+                {
+                case DrawCmdType::Polkadot:
+                {
+                    // the pattern depends on absolute position, so only the visible part is generated
+                    const int x1 = SDL_max(cmd.x1, clip.x);
+                    const int y1 = SDL_max(cmd.y1, clip.y);
+                    const int x2 = SDL_min(cmd.x2, clip.x + clip.w);
+                    const int y2 = SDL_min(cmd.y2, clip.y + clip.h);
+                    if (x1 >= x2 || y1 >= y2)
+                    {
+                        break;
+                    }
+                    if (polkadotCache != NULL)
+                    {
+                        polkadotCache->draw(renderer, x1, y1, x2, y2);
+                    }
+                    else
+                    {
+                        Polkadot(x1, y1, x2, y2).Draw(renderer);
+                    }
+                    break;
+                }
+                case DrawCmdType::Layer:
+                {
+                    const LayerRef &ref = layers[cmd.x1];
+                    ref.layer->draw(renderer, sortByState, *ref.list, ref.serial);
+                    break;
+                }
+                default:
+                    break;
+                }
+                stateSet = false;
+                continue;
+            }
+
+            if (!stateSet)
+            {
+                setRenderDrawBlendMode(renderer, color.a != 255 ? SDL_BLENDMODE_BLEND : SDL_BLENDMODE_NONE);
+                setRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+                stateSet = true;
+            }
+        }
+        if (stateSet)
+        {
+            flushBatches(renderer, color);
+        }
+
+        runBeg = runEnd;
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <vector>
+#include <SDL.h>
+
+#include "Colmake.h"
+#include "Vector2d.h"
+#include "CircleAtlas.h"
+#include "PolkadotCache.h"
+#include "FractalTreeCache.h"
+#include "Utils.h"
+
+class Layer;
+class DrawList;
+
+/**
+ * Layer command target: the layer and which of its recordings the frame draws.
+ */
+struct LayerRef
+{
+    Layer *layer;
+    DrawList *list; // flushed by the thread drawing the frame, never recorded into while referenced
+    int serial;
+};
+
+enum class DrawCmdType : Uint8
+{
+    Rect,          // (x1, y1) position, (x2, y2) size
+    Ellipse,       // (x1, y1) center, (x2, y2) radii
+    EllipseBorder, // (x1, y1) center, (x2, y2) radii
+    Line,          // (x1, y1) - (x2, y2)
+    Dot,           // (x1, y1)
+    Polygon,       // x1 first vertex, x2 vertex count
+    Polkadot,      // (x1, y1) - (x2, y2) region
+    FractalTree,   // (x1, y1) root, x2 length, y2 length seed, x3 angle, y3 angle seed
+    AALine,        // (x1, y1) - (x2, y2)
+    Layer,         // x1 index into layers
+};
+
+static const int k_drawCmdTypeCnt = (int)DrawCmdType::Layer + 1;
+
+struct DrawCmd
+{
+    DrawCmdType type;
+    Color color;
+    int x1, y1, x2, y2, x3, y3;
+};
+
+/**
+ * Per-frame list of recorded draw commands.
+ * flush() sets color and blend mode once per run of commands with equal state
+ * and issues their geometry as batched SDL_RenderFillRects / SDL_RenderDrawLines / SDL_RenderDrawPoints,
+ * filled ellipses and polygons go in as scanline rects, anti-aliased lines and fractal trees as points per alpha level.
+ */
+class DrawList
+{
+public:
+    void clear();
+    bool empty() const { return cmds.empty(); }
+    size_t size() const { return cmds.size(); }
+    const std::vector<DrawCmd> &getCmds() const { return cmds; }
+    const int *getVx() const { return vx.data(); }
+    const int *getVy() const { return vy.data(); }
+    const std::vector<LayerRef> &getLayers() const { return layers; }
+
+    void addRect(int x, int y, int width, int height, Color color);
+    void addEllipse(int x, int y, int rx, int ry, Color color);
+    void addEllipseBorder(int x, int y, int rx, int ry, Color color);
+    void addLine(int x1, int y1, int x2, int y2, Color color);
+    void addAALine(int x1, int y1, int x2, int y2, Color color);
+    void addDot(int x, int y, Color color);
+    void addPolygon(const int *px, const int *py, int numOfEdges, Color color);
+    void addPolygon(const Vector2 *edgesPos, int numOfEdges, Color color);
+    void addPolkadot(int x1, int y1, int x2, int y2);
+    void addFractalTree(int x, int y, int lineLength, int lineLengthSeed, int angle, int angleSeed, Color color);
+    void addLayer(Layer *layer, int recording);
+
+    /**
+     * Record n shapes from structure of arrays, coordinates are truncated to pixels like the int overloads get them.
+     * Commands are appended in place, the list doesn't allocate once it has grown to the frame's size.
+     */
+    void addCircles(const float *x, const float *y, const float *r, const Color *colors, size_t n);
+    void addLines(const float *x1, const float *y1, const float *x2, const float *y2, const Color *colors, size_t n,
+                  bool antialias);
+    void addRects(const float *x, const float *y, const float *width, const float *height, const Color *colors, size_t n);
+    void addDots(const float *x, const float *y, const Color *colors, size_t n);
+
+    /**
+     * Issue recorded commands. With sortByState commands are stable sorted by color and blend mode first,
+     * so shapes of different color may be drawn in other order than recorded. Layers are never reordered,
+     * sorting happens only between them.
+     */
+    void flush(SDL_Renderer *renderer, bool sortByState = false);
+
+    /**
+     * Conservative check of command bounds against the clip rect, false only when nothing of it can show.
+     * Polygons are clipped by filledPolygonSpans instead, trees and layers always pass.
+     */
+    static bool isVisible(const DrawCmd &cmd, const SDL_Rect &clip);
+
+    /**
+     * Draw circles (ellipses with rx == ry) as sprites from the atlas, NULL to fill them as spans.
+     */
+    void setCircleAtlas(CircleAtlas *atlas, bool antialias) { circleAtlas = atlas; circleAntialias = antialias; }
+
+    /**
+     * Draw polkadot regions from cached textures, NULL to generate them every flush.
+     */
+    void setPolkadotCache(PolkadotCache *cache) { polkadotCache = cache; }
+
+    /**
+     * Take fractal tree geometry (or textures) from the cache, NULL to generate trees every flush.
+     */
+    void setFractalTreeCache(FractalTreeCache *cache) { treeCache = cache; }
+    FractalTreeCache *getFractalTreeCache() const { return treeCache; }
+
+private:
+    void add(DrawCmdType type, Color color, int x1, int y1, int x2 = 0, int y2 = 0, int x3 = 0, int y3 = 0);
+    void reserve(size_t n);
+    void flushBatches(SDL_Renderer *renderer, Color color);
+
+    std::vector<DrawCmd> cmds;
+    std::vector<int> vx, vy; // polygon vertices
+    std::vector<LayerRef> layers;
+
+    CircleAtlas *circleAtlas = NULL;
+    bool circleAntialias = false;
+    PolkadotCache *polkadotCache = NULL;
+    FractalTreeCache *treeCache = NULL;
+
+    // flush scratch, kept to avoid allocations every frame
+    std::vector<int> order;
+    std::vector<Uint32> segments; // sort segment of every command, layers split them
+    std::vector<SDL_Rect> rects;
+    std::vector<SDL_Point> points;
+    std::vector<SDL_Point> linePoints;
+    std::vector<int> lineChains; // first point of every polyline in linePoints
+    AALineBatch aaLines;
+};
@@ -0,0 +1,254 @@
+#include "FractalTreeCache.h"
+#include "FrameArena.h"
+#include <climits>
+
+namespace
+{
+struct Branch
+{
+    int x, y;
+    int lineLength;
+    int angle;
+};
+
+// Trees with at least this many levels are generated in parallel
+const int k_parallelLevels = 12;
+// Biggest texture a tree is rasterized into
+const int k_maxTextureSize = 4096;
+
+void branchEnd(const Branch &b, int &endX, int &endY)
+{
+    double angleInRad = ((double)b.angle * M_PI) / 180.0;
+
+    endX = (int)(b.x - (double)b.lineLength * cos(angleInRad));
+    endY = (int)(b.y - (double)b.lineLength * sin(angleInRad));
+}
+
+// Add branch and return whether it has children, like RenderTreeLines (a non positive seed never shrinks, so it's a single branch)
+bool growBranch(const Branch &b, int lineLengthSeed, int angleSeed, AALineBatch &points, Branch &left, Branch &right)
+{
+    int endX, endY;
+    branchEnd(b, endX, endY);
+    points.addLine(b.x, b.y, endX, endY);
+
+    if (b.lineLength > 20 && lineLengthSeed > 0)
+    {
+        left = {endX, endY, b.lineLength - lineLengthSeed, b.angle + angleSeed};
+        right = {endX, endY, b.lineLength - lineLengthSeed, b.angle - angleSeed};
+        return true;
+    }
+    return false;
+}
+
+void generateSubtree(const Branch &root, int lineLengthSeed, int angleSeed, AALineBatch &points)
+{
+    std::vector<Branch> stack;
+    stack.push_back(root);
+    while (!stack.empty())
+    {
+        const Branch b = stack.back();
+        stack.pop_back();
+
+        Branch left, right;
+        if (growBranch(b, lineLengthSeed, angleSeed, points, left, right))
+        {
+            stack.push_back(right);
+            stack.push_back(left);
+        }
+    }
+}
+}
+
+FractalTreeCache::~FractalTreeCache()
+{
+    release();
+}
+
+void FractalTreeCache::release()
+{
+    for (auto &it : entries)
+    {
+        if (it.second->texture != NULL)
+        {
+            SDL_DestroyTexture(it.second->texture);
+        }
+    }
+    entries.clear();
+    owner = NULL;
+}
+
+void FractalTreeCache::setTextures(bool enabled)
+{
+    textures = enabled;
+    if (!enabled)
+    {
+        for (auto &it : entries)
+        {
+            if (it.second->texture != NULL)
+            {
+                SDL_DestroyTexture(it.second->texture);
+                it.second->texture = NULL;
+            }
+        }
+    }
+}
+
+void FractalTreeCache::generate(const FractalTreeParams &params, AALineBatch &points, WorkerPool *pool)
+{
+    const Branch root = {params.x, params.y, params.lineLength, params.angle};
+
+    int levels = 1;
+    if (params.lineLength > 20 && params.lineLengthSeed > 0)
+    {
+        levels += (params.lineLength - 20 + params.lineLengthSeed - 1) / params.lineLengthSeed;
+    }
+    if (pool == NULL || pool->getThreadCnt() < 2 || levels < k_parallelLevels)
+    {
+        generateSubtree(root, params.lineLengthSeed, params.angleSeed, points);
+        return;
+    }
+
+    // grow the top levels here until there are enough subtrees to spread over the workers
+    std::vector<Branch> frontier(1, root);
+    std::vector<Branch> next;
+    const size_t wanted = pool->getThreadCnt() * 8;
+    while (!frontier.empty() && frontier.size() < wanted)
+    {
+        next.clear();
+        for (const Branch &b : frontier)
+        {
+            Branch left, right;
+            if (growBranch(b, params.lineLengthSeed, params.angleSeed, points, left, right))
+            {
+                next.push_back(left);
+                next.push_back(right);
+            }
+        }
+        frontier.swap(next);
+    }
+
+    std::vector<AALineBatch> parts(frontier.size());
+    pool->parallelFor((int)frontier.size(), [&](int i) {
+        generateSubtree(frontier[i], params.lineLengthSeed, params.angleSeed, parts[i]);
+    });
+    for (const AALineBatch &part : parts)
+    {
+        points.append(part);
+    }
+}
+
+FractalTreeCache::Entry &FractalTreeCache::getEntry(const FractalTreeParams &params)
+{
+    std::unique_ptr<Entry> &entry = entries[params];
+    if (!entry)
+    {
+        entry.reset(new Entry());
+        generate(params, entry->points, workerPool);
+    }
+    entry->lastFrame = frame;
+    return *entry;
+}
+
+const AALineBatch &FractalTreeCache::getPoints(const FractalTreeParams &params)
+{
+    return getEntry(params).points;
+}
+
+bool FractalTreeCache::updateTexture(SDL_Renderer *renderer, Entry &entry, Color color)
+{
+    const Color &c = entry.textureColor;
+    if (entry.texture != NULL && c.r == color.r && c.g == color.g && c.b == color.b && c.a == color.a)
+    {
+        return true;
+    }
+    if (entry.texture != NULL)
+    {
+        SDL_DestroyTexture(entry.texture);
+        entry.texture = NULL;
+    }
+    if (entry.points.empty())
+    {
+        return false;
+    }
+
+    int minX = INT_MAX, minY = INT_MAX, maxX = INT_MIN, maxY = INT_MIN;
+    entry.points.forEachPoint([&](const SDL_Point &p, int) {
+        minX = SDL_min(minX, p.x);
+        minY = SDL_min(minY, p.y);
+        maxX = SDL_max(maxX, p.x);
+        maxY = SDL_max(maxY, p.y);
+    });
+    const int w = maxX - minX + 1;
+    const int h = maxY - minY + 1;
+    if (w > k_maxTextureSize || h > k_maxTextureSize)
+    {
+        return false;
+    }
+
+    // accumulate coverage the way blending the points one after another would
+    FrameArena &arena = FrameArena::local();
+    FrameArena::Scope scope(arena);
+    Uint32 *pixels = arena.alloc<Uint32>((size_t)w * h);
+    SDL_memset(pixels, 0, (size_t)w * h * sizeof(Uint32));
+    entry.points.forEachPoint([&](const SDL_Point &p, int level) {
+        Uint32 &px = pixels[(p.y - minY) * w + (p.x - minX)];
+        const Uint32 a = AALineBatch::levelAlpha(level, color.a);
+        const Uint32 d = px >> 24;
+        px = (d + a - d * a / 255) << 24;
+    });
+    const Uint32 rgb = ((Uint32)color.r << 16) | ((Uint32)color.g << 8) | color.b;
+    for (int i = 0; i < w * h; i++)
+    {
+        pixels[i] |= rgb;
+    }
+
+    entry.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, w, h);
+    if (entry.texture == NULL)
+    {
+        return false;
+    }
+    ::updateTexture(entry.texture, NULL, pixels, w * sizeof(Uint32));
+    setTextureBlendMode(entry.texture, SDL_BLENDMODE_BLEND);
+    entry.bounds = {minX, minY, w, h};
+    entry.textureColor = color;
+    return true;
+}
+
+void FractalTreeCache::draw(SDL_Renderer *renderer, const FractalTreeParams &params, Color color)
+{
+    if (owner != renderer)
+    {
+        release();
+        owner = renderer;
+    }
+
+    Entry &entry = getEntry(params);
+    if (textures && updateTexture(renderer, entry, color))
+    {
+        renderCopy(renderer, entry.texture, NULL, &entry.bounds);
+        return;
+    }
+
+    drawBatch.append(entry.points);
+    drawBatch.flush(renderer, color);
+}
+
+void FractalTreeCache::endFrame()
+{
+    for (auto it = entries.begin(); it != entries.end();)
+    {
+        if (it->second->lastFrame != frame)
+        {
+            if (it->second->texture != NULL)
+            {
+                SDL_DestroyTexture(it->second->texture);
+            }
+            it = entries.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    ++frame;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <SDL.h>
+
+#include "Colmake.h"
+#include "Utils.h"
+#include "WorkerPool.h"
+
+struct FractalTreeParams
+{
+    int x, y;
+    int lineLength, lineLengthSeed;
+    int angle, angleSeed;
+
+    bool operator==(const FractalTreeParams &o) const
+    {
+        return x == o.x && y == o.y && lineLength == o.lineLength && lineLengthSeed == o.lineLengthSeed &&
+               angle == o.angle && angleSeed == o.angleSeed;
+    }
+};
+
+/**
+ * Fractal tree geometry cached by parameters.
+ * Branches are generated with an explicit stack, big trees in parallel over subtrees, into anti-aliased
+ * points per alpha level. With textures enabled the tree is also rasterized into a texture per color,
+ * so a static tree costs one SDL_RenderCopy per frame.
+ * Trees not drawn during the last frame are dropped by endFrame().
+ */
+class FractalTreeCache
+{
+public:
+    ~FractalTreeCache();
+
+    /**
+     * Drop all textures and geometry, must be called before the renderer is destroyed.
+     */
+    void release();
+
+    void setWorkerPool(WorkerPool *pool) { workerPool = pool; }
+    void setTextures(bool enabled);
+    bool usesTextures() const { return textures; }
+
+    /**
+     * Anti-aliased points of the tree, generated on first use.
+     */
+    const AALineBatch &getPoints(const FractalTreeParams &params);
+
+    /**
+     * Draw tree from its texture when textures are enabled, from its cached points otherwise.
+     */
+    void draw(SDL_Renderer *renderer, const FractalTreeParams &params, Color color);
+
+    /**
+     * Evict trees not drawn since the previous endFrame().
+     */
+    void endFrame();
+
+    /**
+     * Generate tree points, same branches as RenderTreeLines.
+     */
+    static void generate(const FractalTreeParams &params, AALineBatch &points, WorkerPool *pool = NULL);
+
+private:
+    struct ParamsHash
+    {
+        size_t operator()(const FractalTreeParams &p) const
+        {
+            size_t h = (size_t)p.x;
+            h = h * 31 + (size_t)p.y;
+            h = h * 31 + (size_t)p.lineLength;
+            h = h * 31 + (size_t)p.lineLengthSeed;
+            h = h * 31 + (size_t)p.angle;
+            return h * 31 + (size_t)p.angleSeed;
+        }
+    };
+    struct Entry
+    {
+        AALineBatch points;
+        SDL_Texture *texture = NULL;
+        SDL_Rect bounds = {0, 0, 0, 0};
+        Color textureColor = {0, 0, 0, 0};
+        unsigned int lastFrame = 0;
+    };
+
+    Entry &getEntry(const FractalTreeParams &params);
+    bool updateTexture(SDL_Renderer *renderer, Entry &entry, Color color);
+
+    std::unordered_map<FractalTreeParams, std::unique_ptr<Entry>, ParamsHash> entries;
+    WorkerPool *workerPool = NULL;
+    SDL_Renderer *owner = NULL;
+    AALineBatch drawBatch;
+    unsigned int frame = 0;
+    bool textures = false;
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <type_traits>
+
+/**
+ * Bump allocator for per-frame scratch memory: vertex arrays, polygon edges, ...
+ * Every thread has its own arena, so rasterizers can run in parallel without locks.
+ * Memory stays valid until reset(), which Memake calls once per frame on its thread and
+ * WorkerPool calls on workers after every job. Once the arena has grown to the frame's
+ * high water mark it doesn't allocate anymore.
+ */
+class FrameArena
+{
+public:
+    /**
+     * Restores the arena to its state at construction, for scratch used only inside a function.
+     */
+    class Scope
+    {
+    public:
+        explicit Scope(FrameArena &arena) : arena(arena), block(arena.block.get()), used(arena.used) {}
+        ~Scope()
+        {
+            // memory of blocks started inside the scope is kept until reset()
+            if (arena.block.get() == block)
+            {
+                arena.used = used;
+            }
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        FrameArena &arena;
+        const char *block;
+        size_t used;
+    };
+
+    explicit FrameArena(size_t initialSize = 64 * 1024) : capacity(initialSize)
+    {
+        block.reset(new char[capacity]);
+    }
+
+    /**
+     * Arena of the calling thread.
+     */
+    static FrameArena &local()
+    {
+        thread_local FrameArena arena;
+        return arena;
+    }
+
+    /**
+     * Uninitialized storage for cnt objects of trivial type T.
+     */
+    template<typename T>
+    T *alloc(size_t cnt)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "FrameArena never runs destructors");
+        return static_cast<T *>(allocBytes(cnt * sizeof(T), alignof(T)));
+    }
+
+    void *allocBytes(size_t size, size_t align)
+    {
+        size_t pos = (used + align - 1) & ~(align - 1);
+        if (pos + size > capacity)
+        {
+            // keep the full block alive until reset, pointers into it are still in use
+            retired.push_back(std::move(block));
+            retiredSize += capacity;
+            capacity = std::max(capacity * 2, size + align);
+            block.reset(new char[capacity]);
+            pos = 0;
+        }
+        used = pos + size;
+        return block.get() + pos;
+    }
+
+    /**
+     * Release everything allocated since the last reset. If the frame needed more than one block,
+     * they're merged into one big enough for the whole frame.
+     */
+    void reset()
+    {
+        if (!retired.empty())
+        {
+            capacity += retiredSize;
+            retired.clear();
+            retiredSize = 0;
+            block.reset(new char[capacity]);
+        }
+        used = 0;
+    }
+
+    size_t getCapacity() const { return capacity + retiredSize; }
+
+private:
+    std::unique_ptr<char[]> block;
+    size_t capacity;
+    size_t used = 0;
+    std::vector<std::unique_ptr<char[]>> retired;
+    size_t retiredSize = 0;
+};
@@ -0,0 +1,208 @@
+#include "FrameCapture.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include "BMP.h"
+
+FrameCapture::~FrameCapture()
+{
+    stop();
+}
+
+void FrameCapture::start(const std::string &prefix, Format format, int width, int height, int bufferCnt)
+{
+    stop();
+    if (width <= 0 || height <= 0)
+    {
+        return;
+    }
+
+    this->prefix = prefix;
+    this->format = format;
+    w = width;
+    h = height;
+    frame = 0;
+    dropped = 0;
+
+    // all memory is taken here, capturing doesn't allocate
+    buffers.assign(SDL_max(bufferCnt, 1), std::vector<Uint32>((size_t)w * h));
+    freeBuffers.clear();
+    for (int i = 0; i < (int)buffers.size(); ++i)
+    {
+        freeBuffers.push_back(i);
+    }
+    queued.clear();
+    stopping = false;
+    encoder = std::thread(&FrameCapture::encoderLoop, this);
+}
+
+void FrameCapture::stop()
+{
+    if (!isActive())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    cv.notify_all();
+    encoder.join();
+    buffers.clear();
+}
+
+int FrameCapture::getCapturedCnt() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return frame - dropped;
+}
+
+int FrameCapture::getDroppedCnt() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return dropped;
+}
+
+bool FrameCapture::capture(SDL_Renderer *renderer)
+{
+    const int buffer = acquire();
+    if (buffer < 0)
+    {
+        return false;
+    }
+
+    const SDL_Rect rect = {0, 0, w, h};
+    if (SDL_RenderReadPixels(renderer, &rect, SDL_PIXELFORMAT_ARGB8888, buffers[buffer].data(), w * sizeof(Uint32)) != 0)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        freeBuffers.push_back(buffer);
+        ++frame;
+        ++dropped;
+        return false;
+    }
+    submit(buffer);
+    return true;
+}
+
+bool FrameCapture::capture(const Uint32 *pixels, int pitch)
+{
+    const int buffer = acquire();
+    if (buffer < 0)
+    {
+        return false;
+    }
+
+    for (int y = 0; y < h; ++y)
+    {
+        memcpy(&buffers[buffer][(size_t)y * w], (const Uint8 *)pixels + (size_t)y * pitch, w * sizeof(Uint32));
+    }
+    submit(buffer);
+    return true;
+}
+
+int FrameCapture::acquire()
+{
+    if (!isActive())
+    {
+        return -1;
+    }
+
+    // every buffer is waiting for the encoder, skip the frame rather than stall
+    std::lock_guard<std::mutex> lock(mtx);
+    if (freeBuffers.empty())
+    {
+        ++frame;
+        ++dropped;
+        return -1;
+    }
+    const int buffer = freeBuffers.back();
+    freeBuffers.pop_back();
+    return buffer;
+}
+
+void FrameCapture::submit(int buffer)
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        queued.push_back({buffer, frame++});
+    }
+    cv.notify_all();
+}
+
+void FrameCapture::encoderLoop()
+{
+    // one image reused for every frame, only its pixel data is rewritten
+    BMP bmp(w, h, true);
+    bool failed = false;
+
+    for (;;)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this]() { return stopping || !queued.empty(); });
+            if (queued.empty())
+            {
+                break;
+            }
+            job = queued.front();
+            queued.pop_front();
+        }
+
+        try
+        {
+            write(job, bmp);
+        }
+        catch (const std::exception &e)
+        {
+            // report once, a full disk would fail every frame
+            if (!failed)
+            {
+                std::cerr << "Frame capture: " << e.what() << std::endl;
+                failed = true;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            freeBuffers.push_back(job.buffer);
+        }
+    }
+}
+
+void FrameCapture::write(const Job &job, BMP &bmp)
+{
+    const std::vector<Uint32> &pixels = buffers[job.buffer];
+    char name[16];
+    SDL_snprintf(name, sizeof(name), format == Format::Bmp ? "%05d.bmp" : "%05d.raw", job.frame);
+    const std::string path = prefix + name;
+
+    if (format == Format::Raw)
+    {
+        FILE *f = fopen(path.c_str(), "wb");
+        if (f == NULL)
+        {
+            throw std::runtime_error("Unable to open " + path);
+        }
+        const size_t written = fwrite(pixels.data(), sizeof(Uint32), pixels.size(), f);
+        if (fclose(f) != 0 || written != pixels.size())
+        {
+            throw std::runtime_error("Unable to write " + path);
+        }
+        return;
+    }
+
+    // ARGB8888 is BGRA in memory like the BMP masks, rows go bottom-up and the frame is opaque
+    for (int y = 0; y < h; ++y)
+    {
+        const Uint32 *src = &pixels[(size_t)y * w];
+        Uint32 *dst = (Uint32 *)&bmp.data[(size_t)(h - 1 - y) * w * sizeof(Uint32)];
+        for (int x = 0; x < w; ++x)
+        {
+            dst[x] = src[x] | 0xFF000000;
+        }
+    }
+    bmp.write(path.c_str());
+}
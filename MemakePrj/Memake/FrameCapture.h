@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <SDL.h>
+
+struct BMP;
+
+/**
+ * Recording of presented frames without file writes in the frame loop.
+ * A frame is read back into one of a fixed pool of buffers and queued to an encoder thread, which writes it
+ * as <prefix>00000.bmp (BMP.h writer) or <prefix>00000.raw (top-down ARGB8888, no header) and returns the buffer.
+ * The pool bounds the queue: when every buffer is queued or being written the frame is dropped, the frame loop
+ * never waits for the disk. Frame numbers count captured and dropped frames, so drops show as gaps.
+ */
+class FrameCapture
+{
+public:
+    enum class Format
+    {
+        Bmp,
+        Raw,
+    };
+
+    ~FrameCapture();
+
+    /**
+     * Start the encoder thread for width x height frames with bufferCnt buffers, a running capture is stopped first.
+     */
+    void start(const std::string &prefix, Format format, int width, int height, int bufferCnt = 4);
+
+    /**
+     * Write out queued frames and join the encoder thread.
+     */
+    void stop();
+
+    bool isActive() const { return encoder.joinable(); }
+
+    /**
+     * Read the renderer's current frame back and queue it, call before present. False if the frame was dropped.
+     */
+    bool capture(SDL_Renderer *renderer);
+
+    /**
+     * Queue a copy of ARGB8888 pixels, e.g. a Rasterizer buffer, no readback needed. False if the frame was dropped.
+     */
+    bool capture(const Uint32 *pixels, int pitch);
+
+    int getCapturedCnt() const;
+    int getDroppedCnt() const;
+
+private:
+    struct Job
+    {
+        int buffer;
+        int frame;
+    };
+
+    int acquire();
+    void submit(int buffer);
+    void encoderLoop();
+    void write(const Job &job, BMP &bmp);
+
+    std::string prefix;
+    Format format = Format::Bmp;
+    int w = 0;
+    int h = 0;
+    int frame = 0; // frames seen since start, guarded by mtx like dropped
+    int dropped = 0;
+
+    std::vector<std::vector<Uint32>> buffers;
+    std::thread encoder;
+    mutable std::mutex mtx;
+    std::condition_variable cv;
+    std::vector<int> freeBuffers;
+    std::deque<Job> queued;
+    bool stopping = false;
+};
@@ -0,0 +1,89 @@
+#include "Layer.h"
+
+Layer::~Layer()
+{
+    release();
+}
+
+void Layer::release()
+{
+    if (texture != NULL)
+    {
+        SDL_DestroyTexture(texture);
+    }
+    texture = NULL;
+    owner = NULL;
+    renderedSerial = 0;
+    noTargets = false;
+}
+
+DrawList &Layer::beginRecording()
+{
+    // the current recording stays drawable until endRecording()
+    next = -1;
+    for (int i = 0; i < (int)recordings.size(); ++i)
+    {
+        if (i != current && recordings[i].refs == 0)
+        {
+            next = i;
+            break;
+        }
+    }
+    if (next < 0)
+    {
+        next = (int)recordings.size();
+        recordings.emplace_back();
+        recordings.back().list.reset(new DrawList());
+    }
+    recordings[next].list->clear();
+    return *recordings[next].list;
+}
+
+void Layer::endRecording()
+{
+    current = next;
+    recordings[current].serial = ++serialCnt;
+    recorded = true;
+}
+
+void Layer::draw(SDL_Renderer *renderer, bool sortByState, DrawList &list, int serial)
+{
+    if (owner != renderer)
+    {
+        release();
+        owner = renderer;
+    }
+    if (texture == NULL && !noTargets)
+    {
+        texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, w, h);
+        noTargets = texture == NULL;
+        if (texture != NULL)
+        {
+            // blended commands leave premultiplied color in the texture, composite it so
+            const SDL_BlendMode premultiplied = SDL_ComposeCustomBlendMode(
+                SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+                SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+            if (setTextureBlendMode(texture, premultiplied) != 0)
+            {
+                setTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+            }
+        }
+    }
+    if (texture == NULL)
+    {
+        list.flush(renderer, sortByState);
+        return;
+    }
+
+    if (renderedSerial != serial)
+    {
+        SDL_Texture *prevTarget = SDL_GetRenderTarget(renderer);
+        setRenderTarget(renderer, texture);
+        setRenderDrawColor(renderer, 0, 0, 0, 0);
+        renderClear(renderer);
+        list.flush(renderer, sortByState);
+        setRenderTarget(renderer, prevTarget);
+        renderedSerial = serial;
+    }
+    renderCopy(renderer, texture, NULL, NULL);
+}
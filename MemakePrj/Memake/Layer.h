@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <SDL.h>
+
+#include "DrawList.h"
+
+/**
+ * Static layer: draw commands recorded once and rendered into a screen sized target texture,
+ * which is composited every frame with a single SDL_RenderCopy until the layer is invalidated.
+ * Renderers without render target support flush the recorded commands every frame instead.
+ *
+ * Every recording goes into a list no frame in flight draws, so the layer can be recorded again while
+ * the render thread still draws earlier frames with the previous recording. Recording and references
+ * are managed by the recording thread, the texture belongs to the thread owning the renderer.
+ */
+class Layer
+{
+public:
+    Layer(int w, int h) : w(w), h(h) {}
+    ~Layer();
+
+    /**
+     * Drop texture, must be called before the renderer is destroyed.
+     */
+    void release();
+
+    /**
+     * Empty list for the next recording, the caller configures it like the Memake draw list.
+     */
+    DrawList &beginRecording();
+
+    /**
+     * Make the list from beginRecording() the one drawn from now on.
+     */
+    void endRecording();
+    DrawList &getRecordingList() { return *recordings[next].list; }
+
+    bool isRecorded() const { return recorded; }
+    void setRecorded(bool value) { recorded = value; }
+
+    /**
+     * Latest recording, what addRef() and DrawList::addLayer() take.
+     */
+    int getCurrent() const { return current; }
+    DrawList &getList(int recording) { return *recordings[recording].list; }
+    int getSerial(int recording) const { return recordings[recording].serial; }
+
+    /**
+     * Frames holding a recording, it isn't recorded into again until they're all released.
+     */
+    void addRef(int recording) { ++recordings[recording].refs; }
+    void releaseRef(int recording) { --recordings[recording].refs; }
+
+    /**
+     * Render the recorded commands into the texture again on next draw.
+     */
+    void invalidateTexture() { renderedSerial = 0; }
+
+    /**
+     * Draw recording list, serial tells whether the texture already holds it.
+     */
+    void draw(SDL_Renderer *renderer, bool sortByState, DrawList &list, int serial);
+
+private:
+    struct Recording
+    {
+        std::unique_ptr<DrawList> list;
+        int serial = 0;
+        int refs = 0;
+    };
+
+    int w, h;
+    bool recorded = false;
+
+    // recording thread
+    std::vector<Recording> recordings;
+    int current = -1;
+    int next = -1;
+    int serialCnt = 0;
+
+    // renderer thread, serial 0 is never recorded
+    int renderedSerial = 0;
+    SDL_Texture *texture = NULL;
+    SDL_Renderer *owner = NULL;
+    bool noTargets = false;
+};
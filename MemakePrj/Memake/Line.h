@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Memake.h"
+#include "Utils.h"
 
 class Line
 {
@@ -15,8 +16,13 @@ public:
 
     void Draw(SDL_Renderer *renderer, Color color)
     {
-        SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, 1);
-        SDL_RenderDrawLine(renderer, x1, y1, x2, y2);
+        setRenderDrawColor(renderer, color.r, color.g, color.b, 1);
+        renderDrawLine(renderer, x1, y1, x2, y2);
+    }
+
+    void DrawAntialiased(SDL_Renderer *renderer, Color color)
+    {
+        aaLineColor(renderer, x1, y1, x2, y2, color);
     }
 
     int x1;
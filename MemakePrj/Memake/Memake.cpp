@@ -1,6 +1,12 @@
 #include "Memake.h"
 #include <stdio.h>
 #include <math.h>
+#include <algorithm>
+
+static float ticksToMs(Uint64 ticks)
+{
+    return (float)(ticks * 1000.0 / SDL_GetPerformanceFrequency());
+}
 
 Memake::Memake(int width, int height, string window_name)
 {
@@ -13,8 +19,10 @@ Memake::Memake(int width, int height, string window_name)
     }
 
     window = SDL_CreateWindow(window_name.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, w, h, SDL_WINDOW_SHOWN);
-    renderer = SDL_CreateRenderer(window, -1, 0);
+    createRenderer(windowOptions);
     setScreenBackgroundColor({0x0, 0x0, 0x0});
+    initCircleSprites();
+    initCaches();
 }
 
 Memake::Memake(int width, int height, string window_name, Color backgroundColor = {0x0, 0x0, 0x0})
@@ -28,149 +36,1203 @@ Memake::Memake(int width, int height, string window_name, Color backgroundColor
     }
 
     window = SDL_CreateWindow(window_name.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, w, h, SDL_WINDOW_SHOWN);
-    renderer = SDL_CreateRenderer(window, -1, 0);
+    createRenderer(windowOptions);
+    bgColor = backgroundColor;
+    initCircleSprites();
+    initCaches();
+}
+
+Memake::Memake(int width, int height, string window_name, const WindowOptions &options, Color backgroundColor)
+{
+    w = width;
+    h = height;
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0)
+    {
+        cout << "Error Initializing Memake";
+    }
+
+    window = SDL_CreateWindow(window_name.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, w, h, SDL_WINDOW_SHOWN);
+    windowOptions = options;
+    createRenderer(windowOptions);
     bgColor = backgroundColor;
+    initCircleSprites();
+    initCaches();
+}
+
+void Memake::createRenderer(const WindowOptions &options)
+{
+    const bool vsync = options.pacing == FramePacing::VSync;
+    const Uint32 vsyncFlag = vsync ? SDL_RENDERER_PRESENTVSYNC : 0;
+
+    int driver = -1;
+    for (int i = 0; !options.renderDriver.empty() && i < SDL_GetNumRenderDrivers(); i++)
+    {
+        SDL_RendererInfo info;
+        if (SDL_GetRenderDriverInfo(i, &info) == 0 && options.renderDriver == info.name)
+        {
+            driver = i;
+        }
+    }
+
+    // requested driver, then best accelerated one, without vsync, software as last resort
+    if (driver >= 0)
+    {
+        renderer = SDL_CreateRenderer(window, driver, vsyncFlag);
+    }
+    if (renderer == NULL)
+    {
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | vsyncFlag);
+    }
+    if (renderer == NULL && vsync)
+    {
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    }
+    if (renderer == NULL)
+    {
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE);
+    }
+    if (renderer == NULL)
+    {
+        cout << "Error Creating Memake Renderer: " << SDL_GetError() << endl;
+        return;
+    }
+    if (driver < 0 && !options.renderDriver.empty())
+    {
+        cout << "Render driver " << options.renderDriver << " not available, using " << getRendererName() << endl;
+    }
+
+    applyFramePacing(options.pacing, options.targetFps);
+}
+
+Memake::Memake(int width, int height, const OffscreenOptions &offscreen, Color backgroundColor)
+{
+    w = width;
+    h = height;
+    this->offscreen = true;
+    offscreenOptions = offscreen;
+
+    // no display needed, a driver chosen through the environment still wins
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+    if (SDL_Init(SDL_INIT_VIDEO) < 0)
+    {
+        cout << "Error Initializing Memake";
+    }
+
+    surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888);
+    renderer = SDL_CreateSoftwareRenderer(surface);
+    bgColor = backgroundColor;
+    initCircleSprites();
+    initCaches();
 }
 
 Memake::~Memake()
 {
+    setStatsLog("");
+    setRenderThread(false);
+    setFrameCapture("");
+    releaseRendererResources();
     SDL_DestroyWindow(window);
-    SDL_FreeSurface(surface);
     SDL_DestroyRenderer(renderer);
+    // offscreen renderer draws into the surface, free it last
+    SDL_FreeSurface(surface);
     SDL_Quit();
 }
 
-SDL_Renderer *Memake::GetRenderer()
+SDL_Renderer *Memake::GetRenderer()
+{
+    return renderer;
+}
+
+SDL_Window *Memake::GetWindow()
+{
+    return window;
+}
+
+SDL_Surface *Memake::GetSurface()
+{
+    return surface;
+}
+
+int Memake::getMousePosX()
+{
+    return mousePosX;
+}
+
+int Memake::getMousePosY()
+{
+    return mousePosY;
+}
+
+void Memake::setMousePos()
+{
+    SDL_GetMouseState(&mousePosX, &mousePosY);
+}
+
+float Memake::getDeltaTime()
+{
+    return deltatime;
+}
+
+void Memake::setDeltaTime()
+{
+    prevTime = currentTime;
+    currentTime = SDL_GetTicks();
+    deltatime = offscreen ? offscreenOptions.deltaTime : (currentTime - prevTime) / 1000.0f;
+}
+
+void Memake::delay(int delay)
+{
+    SDL_Delay(delay);
+}
+
+const char *Memake::getRendererName()
+{
+    SDL_RendererInfo info;
+    if (renderer == NULL || SDL_GetRendererInfo(renderer, &info) != 0)
+    {
+        return "none";
+    }
+    return info.name;
+}
+
+void Memake::setFramePacing(FramePacing pacing, int targetFps)
+{
+    // kept for renderers created later, the render thread picks it up with the next frame
+    windowOptions.pacing = pacing;
+    windowOptions.targetFps = targetFps;
+    if (!threaded)
+    {
+        applyFramePacing(pacing, targetFps);
+    }
+}
+
+void Memake::applyFramePacing(FramePacing pacing, int targetFps)
+{
+    this->pacing = pacing;
+    this->targetFps = SDL_max(targetFps, 1);
+    nextFrameTicks = 0;
+
+    if (pacing != FramePacing::VSync)
+    {
+        return;
+    }
+
+    // frames come at the display's refresh rate, without vsync in this renderer keep that pace with the timer
+    SDL_DisplayMode mode;
+    const int display = window != NULL ? SDL_GetWindowDisplayIndex(window) : 0;
+    this->targetFps = SDL_GetCurrentDisplayMode(SDL_max(display, 0), &mode) == 0 && mode.refresh_rate > 0 ? mode.refresh_rate : 60;
+
+    SDL_RendererInfo info;
+    if (renderer == NULL || SDL_GetRendererInfo(renderer, &info) != 0 || (info.flags & SDL_RENDERER_PRESENTVSYNC) == 0)
+    {
+        this->pacing = FramePacing::FixedFps;
+    }
+}
+
+void Memake::paceFrame()
+{
+    const Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 now = SDL_GetPerformanceCounter();
+
+    if (pacing == FramePacing::FixedFps)
+    {
+        const Uint64 period = freq / targetFps;
+        if (nextFrameTicks == 0)
+        {
+            nextFrameTicks = now + period;
+        }
+        if (now < nextFrameTicks)
+        {
+            // SDL_Delay may oversleep by a millisecond or so, spin the rest
+            const Uint64 spinTicks = freq * 2 / 1000;
+            if (nextFrameTicks - now > spinTicks)
+            {
+                SDL_Delay((Uint32)((nextFrameTicks - now - spinTicks) * 1000 / freq));
+            }
+            while ((now = SDL_GetPerformanceCounter()) < nextFrameTicks)
+            {
+            }
+        }
+        // next deadline keeps the grid unless we fell a whole frame behind
+        nextFrameTicks = now > nextFrameTicks + period ? now + period : nextFrameTicks + period;
+    }
+
+    if (lastFrameTicks != 0)
+    {
+        const double interval = (now - lastFrameTicks) * 1000.0 / freq;
+        intervalMin = intervalCnt == 0 ? interval : SDL_min(intervalMin, interval);
+        intervalMax = intervalCnt == 0 ? interval : SDL_max(intervalMax, interval);
+        intervalSum += interval;
+        intervalSqSum += interval * interval;
+        intervalCnt++;
+        if (pacing != FramePacing::Uncapped && interval > 1500.0 / targetFps)
+        {
+            lateCnt++;
+        }
+    }
+    lastFrameTicks = now;
+}
+
+void Memake::printFrameJitter()
+{
+    if (intervalCnt == 0)
+    {
+        return;
+    }
+
+    const double mean = intervalSum / intervalCnt;
+    const double deviation = sqrt(SDL_max(intervalSqSum / intervalCnt - mean * mean, 0.0));
+    printf("frames %d, interval ms: mean %.3f (%.1f fps) stddev %.3f min %.3f max %.3f, late %d\n", intervalCnt + 1,
+           mean, 1000.0 / mean, deviation, intervalMin, intervalMax, lateCnt);
+}
+
+const FrameStats &Memake::getFrameStats()
+{
+    return frameStats;
+}
+
+void Memake::setStatsOverlay(bool enabled)
+{
+    statsOverlay = enabled;
+    statsHistory.clear();
+    statsHistoryPos = 0;
+}
+
+bool Memake::setStatsLog(const string &path, int periodFrames)
+{
+    if (statsLog != NULL)
+    {
+        fclose(statsLog);
+        statsLog = NULL;
+    }
+    statsSum = FrameStats();
+    statsSumCnt = 0;
+    statsLogPeriod = SDL_max(periodFrames, 1);
+    if (path.empty())
+    {
+        return true;
+    }
+
+    statsLog = fopen(path.c_str(), "w");
+    if (statsLog == NULL)
+    {
+        return false;
+    }
+    // primitive columns in DrawCmdType order
+    fprintf(statsLog, "frame,sdl_calls,pixels,clear_ms,draw_ms,present_ms,"
+            "rect,ellipse,ellipse_border,line,dot,polygon,polkadot,fractal_tree,aa_line,layer\n");
+    return true;
+}
+
+void Memake::setFrameCapture(const string &prefix, FrameCapture::Format format, int bufferCnt)
+{
+    // the render thread captures, it must be idle while the capture restarts
+    if (threaded)
+    {
+        waitRenderedFrames();
+    }
+    if (prefix.empty())
+    {
+        frameCapture.stop();
+        return;
+    }
+    frameCapture.start(prefix, format, w, h, bufferCnt);
+}
+
+void Memake::captureFrame()
+{
+    if (!frameCapture.isActive())
+    {
+        return;
+    }
+    if (usesRasterizer())
+    {
+        // the frame is in memory already, no readback
+        const Rasterizer &frame = *rasterizer;
+        frameCapture.capture(frame.getPixels(), frame.getPitch());
+    }
+    else
+    {
+        frameCapture.capture(renderer);
+    }
+}
+
+void Memake::endFrameStats()
+{
+    frameStats = curStats;
+    curStats = FrameStats();
+    curStats.frame = frameStats.frame + 1;
+
+    if (statsOverlay)
+    {
+        if ((int)statsHistory.size() < k_statsHistoryCnt)
+        {
+            statsHistory.push_back(frameStats);
+        }
+        else
+        {
+            statsHistory[statsHistoryPos] = frameStats;
+        }
+        statsHistoryPos = (statsHistoryPos + 1) % k_statsHistoryCnt;
+    }
+
+    if (statsLog != NULL)
+    {
+        statsSum.sdlCalls += frameStats.sdlCalls;
+        statsSum.pixels += frameStats.pixels;
+        statsSum.clearMs += frameStats.clearMs;
+        statsSum.drawMs += frameStats.drawMs;
+        statsSum.presentMs += frameStats.presentMs;
+        for (int i = 0; i < k_drawCmdTypeCnt; i++)
+        {
+            statsSum.prims[i] += frameStats.prims[i];
+        }
+        if (++statsSumCnt == statsLogPeriod)
+        {
+            writeStatsLog();
+        }
+    }
+}
+
+void Memake::writeStatsLog()
+{
+    // means per frame of the period, stamped with its last frame
+    const double n = statsSumCnt;
+    fprintf(statsLog, "%llu,%.1f,%.0f,%.3f,%.3f,%.3f", (unsigned long long)frameStats.frame, statsSum.sdlCalls / n,
+            statsSum.pixels / n, statsSum.clearMs / n, statsSum.drawMs / n, statsSum.presentMs / n);
+    for (int i = 0; i < k_drawCmdTypeCnt; i++)
+    {
+        fprintf(statsLog, ",%.1f", statsSum.prims[i] / n);
+    }
+    fprintf(statsLog, "\n");
+    statsSum = FrameStats();
+    statsSumCnt = 0;
+}
+
+void Memake::drawStatsOverlay()
+{
+    if (!statsOverlay || statsHistory.empty())
+    {
+        return;
+    }
+
+    // one 2 pixel column per frame, oldest left, 3 pixels per ms
+    static const int k_x = 8, k_y = 8, k_colW = 2, k_graphH = 100, k_pxPerMs = 3;
+    const int cnt = (int)statsHistory.size();
+    const SDL_Rect back = {k_x, k_y, k_statsHistoryCnt * k_colW, k_graphH};
+    setRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    setRenderDrawColor(renderer, 0, 0, 0, 160);
+    renderFillRect(renderer, &back);
+    setRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+
+    const Color colors[3] = {Colmake.dodgerblue, Colmake.limegreen, Colmake.orange};
+    for (int part = 0; part < 3; part++)
+    {
+        overlayRects.clear();
+        for (int i = 0; i < cnt; i++)
+        {
+            const FrameStats &fs = statsHistory[(statsHistoryPos + i) % cnt];
+            const float beg = part == 0 ? 0.f : part == 1 ? fs.clearMs : fs.clearMs + fs.drawMs;
+            const float end = beg + (part == 0 ? fs.clearMs : part == 1 ? fs.drawMs : fs.presentMs);
+            const int y0 = SDL_min((int)(beg * k_pxPerMs), k_graphH);
+            const int y1 = SDL_min((int)(end * k_pxPerMs), k_graphH);
+            if (y1 > y0)
+            {
+                overlayRects.push_back({k_x + i * k_colW, k_y + k_graphH - y1, k_colW, y1 - y0});
+            }
+        }
+        if (!overlayRects.empty())
+        {
+            setRenderDrawColor(renderer, colors[part].r, colors[part].g, colors[part].b, 255);
+            renderFillRects(renderer, overlayRects.data(), (int)overlayRects.size());
+        }
+    }
+
+    const int budgetY = k_y + k_graphH - SDL_min(1000 * k_pxPerMs / SDL_max(targetFps, 1), k_graphH);
+    setRenderDrawColor(renderer, 255, 255, 255, 255);
+    renderDrawLine(renderer, back.x, budgetY, back.x + back.w - 1, budgetY);
+}
+
+void Memake::setScreenBackgroundColor(Color color)
+{
+    bgColor = color;
+    if (scene != NULL)
+    {
+        scene->invalidate();
+    }
+}
+
+void Memake::setDeferredDrawing(bool enabled, bool sortByState)
+{
+    flushDrawList();
+    userDeferred = enabled;
+    updateDeferred();
+    this->sortByState = sortByState;
+}
+
+void Memake::initCircleSprites()
+{
+    // copying textures is only cheaper than filling spans when the GPU does it
+    SDL_RendererInfo info;
+    const bool accelerated = renderer != NULL && SDL_GetRendererInfo(renderer, &info) == 0 &&
+        (info.flags & SDL_RENDERER_ACCELERATED) != 0;
+    setCircleSprites(accelerated);
+}
+
+void Memake::initCaches()
+{
+    workerPool.reset(offscreen && offscreenOptions.workerCnt > 0 ? new WorkerPool(offscreenOptions.workerCnt) : new WorkerPool());
+    treeCache.setWorkerPool(workerPool.get());
+    configureDrawList(drawList);
+    configureDrawList(immediateList);
+}
+
+void Memake::configureDrawList(DrawList &list)
+{
+    list.setCircleAtlas(circleSprites ? &circleAtlas : NULL, circleAntialias);
+    list.setPolkadotCache(&polkadotCache);
+    list.setFractalTreeCache(&treeCache);
+}
+
+void Memake::updateDeferred()
+{
+    deferred = userDeferred || threaded || scene != NULL || rasterizer != NULL;
+}
+
+void Memake::releaseRendererResources()
+{
+    if (framebuffer != NULL)
+    {
+        SDL_DestroyTexture(framebuffer);
+        framebuffer = NULL;
+    }
+    if (rasterTexture != NULL)
+    {
+        SDL_DestroyTexture(rasterTexture);
+        rasterTexture = NULL;
+    }
+    circleAtlas.release();
+    polkadotCache.release();
+    treeCache.release();
+    if (sceneCanvas != NULL)
+    {
+        SDL_DestroyTexture(sceneCanvas);
+        sceneCanvas = NULL;
+    }
+    sceneNoTargets = false;
+    for (auto &it : layers)
+    {
+        it.second->release();
+    }
+}
+
+void Memake::setRenderThread(bool enabled, int maxFrameLatency)
+{
+    if (enabled == threaded)
+    {
+        return;
+    }
+    if (offscreen)
+    {
+        cout << "Render thread is not available offscreen" << endl;
+        return;
+    }
+
+    if (enabled)
+    {
+        // renderer is recreated on the render thread, textures of this one go with it
+        flushDrawList();
+        releaseRendererResources();
+        SDL_DestroyRenderer(renderer);
+        renderer = NULL;
+
+        frameSlots.clear();
+        freeSlots.clear();
+        queuedSlots.clear();
+        for (int i = 0; i < SDL_max(maxFrameLatency, 1) + 1; i++)
+        {
+            frameSlots.emplace_back(new FrameSlot());
+            freeSlots.push_back(frameSlots.back().get());
+        }
+        renderThreadStop = false;
+        renderThreadReady = false;
+        threaded = true;
+        updateDeferred();
+        renderThread = std::thread(&Memake::renderThreadLoop, this);
+
+        // renderer info and pacing are queried from this thread, wait until they exist
+        std::unique_lock<std::mutex> lock(frameMtx);
+        frameCv.wait(lock, [this]() { return renderThreadReady; });
+    }
+    else
+    {
+        waitRenderedFrames();
+        {
+            std::lock_guard<std::mutex> lock(frameMtx);
+            renderThreadStop = true;
+        }
+        frameCv.notify_all();
+        renderThread.join();
+        for (auto &slot : frameSlots)
+        {
+            releaseLayerRefs(slot->layerRefs);
+        }
+        frameSlots.clear();
+        freeSlots.clear();
+        recordSlot = NULL;
+        threaded = false;
+        updateDeferred();
+        createRenderer(windowOptions);
+        treeCache.setTextures(treeTextures);
+    }
+}
+
+void Memake::beginRecordedFrame()
+{
+    // waiting for a free slot is what bounds the frame latency
+    std::unique_lock<std::mutex> lock(frameMtx);
+    frameCv.wait(lock, [this]() { return !freeSlots.empty(); });
+    recordSlot = freeSlots.front();
+    freeSlots.pop_front();
+    lock.unlock();
+
+    // the slot's last frame is drawn, layers may record into what it held
+    releaseLayerRefs(recordSlot->layerRefs);
+
+    recordSlot->hasFramebuffer = false;
+    recordSlot->bgColor = bgColor;
+    recordSlot->sortByState = sortByState;
+    recordSlot->pacing = windowOptions.pacing;
+    recordSlot->targetFps = windowOptions.targetFps;
+    recordSlot->treeTextures = treeTextures;
+}
+
+void Memake::submitRecordedFrame()
+{
+    // hand recorded commands over, get back the slot's empty list
+    DrawList &list = recordSlot->lists[recordSlot->hasFramebuffer ? 1 : 0];
+    std::swap(drawList, list);
+    configureDrawList(list);
+
+    {
+        std::lock_guard<std::mutex> lock(frameMtx);
+        queuedSlots.push_back(recordSlot);
+        recordSlot = NULL;
+    }
+    frameCv.notify_all();
+}
+
+void Memake::waitRenderedFrames()
+{
+    std::unique_lock<std::mutex> lock(frameMtx);
+    frameCv.wait(lock, [this]() { return freeSlots.size() + (recordSlot != NULL ? 1 : 0) == frameSlots.size(); });
+}
+
+void Memake::renderThreadLoop()
+{
+    FramePacing slotPacing;
+    int slotFps;
+    {
+        std::lock_guard<std::mutex> lock(frameMtx);
+        createRenderer(windowOptions);
+        slotPacing = windowOptions.pacing;
+        slotFps = windowOptions.targetFps;
+        renderThreadReady = true;
+    }
+    frameCv.notify_all();
+
+    for (;;)
+    {
+        FrameSlot *slot;
+        {
+            std::unique_lock<std::mutex> lock(frameMtx);
+            frameCv.wait(lock, [this]() { return renderThreadStop || !queuedSlots.empty(); });
+            if (queuedSlots.empty())
+            {
+                break;
+            }
+            slot = queuedSlots.front();
+            queuedSlots.pop_front();
+        }
+
+        // settings changed on the recording thread since the last frame
+        if (slot->pacing != slotPacing || slot->targetFps != slotFps)
+        {
+            slotPacing = slot->pacing;
+            slotFps = slot->targetFps;
+            applyFramePacing(slotPacing, slotFps);
+        }
+        if (slot->treeTextures != treeCache.usesTextures())
+        {
+            treeCache.setTextures(slot->treeTextures);
+        }
+
+        FrameArena::local().reset();
+        RenderCounters &counters = RenderCounters::local();
+        counters.reset();
+        const Uint64 clearBeg = SDL_GetPerformanceCounter();
+        setRenderDrawColor(renderer, slot->bgColor.r, slot->bgColor.g, slot->bgColor.b, 0xFF);
+        renderClear(renderer);
+
+        const Uint64 drawBeg = SDL_GetPerformanceCounter();
+        slot->lists[0].flush(renderer, slot->sortByState);
+        slot->lists[0].clear();
+        if (slot->hasFramebuffer)
+        {
+            if (framebuffer == NULL)
+            {
+                framebuffer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, w, h);
+            }
+            updateTexture(framebuffer, NULL, slot->pixels.data(), w * sizeof(Uint32));
+            renderCopy(renderer, framebuffer, NULL, NULL);
+            slot->lists[1].flush(renderer, slot->sortByState);
+            slot->lists[1].clear();
+        }
+
+        const Uint64 presentBeg = SDL_GetPerformanceCounter();
+        captureFrame();
+        renderPresent(renderer);
+        const Uint64 presentEnd = SDL_GetPerformanceCounter();
+        paceFrame();
+        polkadotCache.endFrame();
+        treeCache.endFrame();
+
+        {
+            std::lock_guard<std::mutex> lock(frameMtx);
+            renderedStats.sdlCalls = counters.calls;
+            renderedStats.pixels = counters.pixels;
+            renderedStats.clearMs = ticksToMs(drawBeg - clearBeg);
+            renderedStats.drawMs = ticksToMs(presentBeg - drawBeg);
+            renderedStats.presentMs = ticksToMs(presentEnd - presentBeg);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(frameMtx);
+            freeSlots.push_back(slot);
+        }
+        frameCv.notify_all();
+    }
+
+    releaseRendererResources();
+    SDL_DestroyRenderer(renderer);
+    renderer = NULL;
+}
+
+void Memake::setFractalTreeTextures(bool enabled)
+{
+    flushDrawList();
+    treeTextures = enabled;
+    if (!threaded)
+    {
+        treeCache.setTextures(enabled);
+    }
+}
+
+void Memake::setCircleSprites(bool enabled, bool antialias)
+{
+    flushDrawList();
+    circleSprites = enabled;
+    circleAntialias = antialias;
+    configureDrawList(drawList);
+    configureDrawList(immediateList);
+}
+
+void Memake::flushDrawList()
+{
+    if (usesRasterizer())
+    {
+        if (!drawList.empty() || rasterClearPending)
+        {
+            rasterizer->render(drawList, rasterClearPending ? &bgColor : NULL);
+            rasterClearPending = false;
+            drawList.clear();
+        }
+        return;
+    }
+
+    // with render thread, commands go over with the frame
+    if (!threaded && !drawList.empty())
+    {
+        drawList.flush(renderer, sortByState);
+        drawList.clear();
+    }
+}
+
+Color Memake::generateColor(Uint8 r, Uint8 g, Uint8 b)
+{
+    Color newColor = {r, g, b, 255};
+    return newColor;
+}
+
+int Memake::getScreenH()
+{
+    return h;
+}
+
+int Memake::getScreenW()
+{
+    return w;
+}
+
+void Memake::close()
+{
+    keepWindowOpen = false;
+}
+
+char Memake::readKeyInput()
+{
+    switch (event.type)
+    {
+    case SDL_TEXTINPUT:
+        for (int i = 0; i < SDL_TEXTINPUTEVENT_TEXT_SIZE; ++i)
+        {
+            char c = event.text.text[i];
+            // cancel if a non-ascii char is encountered
+            if (c < ' ' || c > '~')
+            {
+                break;
+            }
+            else
+            {
+                return c;
+            }
+        }
+        break;
+    }
+    return ' ';
+}
+
+bool Memake::isKeyDown(SDL_Keycode key)
+{
+    const Uint8 *state = SDL_GetKeyboardState(NULL);
+    return state[SDL_GetScancodeFromKey(key)] != 0;
+}
+
+void Memake::update(std::function<void()> draw)
+{
+    while (keepWindowOpen)
+    {
+        setMousePos();
+        setDeltaTime();
+        FrameArena::local().reset();
+        // previous frame is flushed, or went to the render thread with its own references
+        releaseLayerRefs(layerRefs);
+
+        while (SDL_PollEvent(&event))
+        {
+            if (event.type == SDL_QUIT)
+            {
+                keepWindowOpen = false;
+            }
+            else if (event.type == SDL_RENDER_TARGETS_RESET || event.type == SDL_RENDER_DEVICE_RESET)
+            {
+                // target texture contents are lost
+                waitRenderedFrames();
+                for (auto &it : layers)
+                {
+                    it.second->invalidateTexture();
+                }
+                if (scene != NULL)
+                {
+                    scene->invalidate();
+                }
+            }
+            else if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_EXPOSED)
+            {
+                scenePresent = true;
+            }
+            else if (event.type == SDL_KEYDOWN)
+            {
+                if (event.key.keysym.sym == SDLK_ESCAPE)
+                {
+                    keepWindowOpen = false;
+                }
+            }
+        }
+
+        if (threaded)
+        {
+            beginRecordedFrame();
+            const Uint64 recordBeg = SDL_GetPerformanceCounter();
+            draw();
+            curStats.drawMs = ticksToMs(SDL_GetPerformanceCounter() - recordBeg);
+            submitRecordedFrame();
+            {
+                std::lock_guard<std::mutex> lock(frameMtx);
+                curStats.sdlCalls = renderedStats.sdlCalls;
+                curStats.pixels = renderedStats.pixels;
+                curStats.clearMs = renderedStats.clearMs;
+                curStats.drawMs += renderedStats.drawMs;
+                curStats.presentMs = renderedStats.presentMs;
+            }
+            endFrameStats();
+            continue;
+        }
+
+        RenderCounters &counters = RenderCounters::local();
+        counters.reset();
+        const Uint64 drawBeg = SDL_GetPerformanceCounter();
+        Uint64 clearEnd = drawBeg;
+        if (scene != NULL)
+        {
+            draw();
+            if (!drawSceneFrame(offscreen))
+            {
+                // nothing changed, the window still shows the last frame
+                SDL_WaitEventTimeout(NULL, 1000 / SDL_max(targetFps, 1));
+                continue;
+            }
+        }
+        else
+        {
+            clear();
+            clearEnd = SDL_GetPerformanceCounter();
+
+            // compose(); // set this to active to use unwrap wraper
+            draw();
+            flushDrawList();
+        }
+        const Uint64 drawEnd = SDL_GetPerformanceCounter();
+        if (usesRasterizer())
+        {
+            presentRasterizer();
+        }
+        if (offscreen)
+        {
+            endOffscreenFrame(drawBeg);
+        }
+
+        captureFrame();
+
+        // the overlay isn't part of the frame
+        curStats.sdlCalls = counters.calls + 1;
+        curStats.pixels = counters.pixels;
+        drawStatsOverlay();
+        renderPresent(renderer);
+        curStats.clearMs = ticksToMs(clearEnd - drawBeg);
+        curStats.drawMs = ticksToMs(drawEnd - clearEnd);
+        curStats.presentMs = ticksToMs(SDL_GetPerformanceCounter() - drawEnd);
+        endFrameStats();
+
+        paceFrame();
+        polkadotCache.endFrame();
+        treeCache.endFrame();
+    }
+
+    if (threaded)
+    {
+        waitRenderedFrames();
+    }
+    if (offscreen && offscreenOptions.printFrameTimes)
+    {
+        printFrameTimes();
+    }
+}
+
+void Memake::endOffscreenFrame(Uint64 drawBeg)
 {
-    return renderer;
+    // draw commands are queued until flushed, the frame is done once they're executed
+    SDL_RenderFlush(renderer);
+    const Uint64 drawEnd = SDL_GetPerformanceCounter();
+    frameTimesMs.push_back((float)((drawEnd - drawBeg) * 1000.0 / SDL_GetPerformanceFrequency()));
+
+    const int frame = (int)frameTimesMs.size() - 1;
+    if (!offscreenOptions.dumpPrefix.empty() && frame % SDL_max(offscreenOptions.dumpEvery, 1) == 0)
+    {
+        char name[16];
+        SDL_snprintf(name, sizeof(name), "%05d.bmp", frame);
+        SDL_SaveBMP(surface, (offscreenOptions.dumpPrefix + name).c_str());
+    }
+
+    if ((int)frameTimesMs.size() >= offscreenOptions.frameCnt)
+    {
+        keepWindowOpen = false;
+    }
 }
 
-SDL_Window *Memake::GetWindow()
+bool Memake::isOffscreen()
 {
-    return window;
+    return offscreen;
 }
 
-SDL_Surface *Memake::GetSurface()
+const vector<float> &Memake::getFrameTimesMs()
 {
-    return surface;
+    return frameTimesMs;
 }
 
-int Memake::getMousePosX()
+void Memake::printFrameTimes()
 {
-    return mousePosX;
+    if (frameTimesMs.empty())
+    {
+        return;
+    }
+
+    vector<float> sorted = frameTimesMs;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0;
+    for (float t : sorted)
+    {
+        sum += t;
+    }
+    auto percentile = [&](double p) { return sorted[(size_t)(p * (sorted.size() - 1) + 0.5)]; };
+
+    printf("frames %d, draw ms: avg %.3f min %.3f p50 %.3f p95 %.3f p99 %.3f max %.3f\n", (int)sorted.size(),
+           sum / sorted.size(), sorted.front(), percentile(0.5), percentile(0.95), percentile(0.99), sorted.back());
 }
 
-int Memake::getMousePosY()
+Uint32 *Memake::lockFramebuffer(int &pitch)
 {
-    return mousePosY;
+    if (threaded)
+    {
+        // pixels travel with the frame, uploaded by the render thread
+        recordSlot->pixels.resize(w * h);
+        pitch = w * sizeof(Uint32);
+        return recordSlot->pixels.data();
+    }
+    if (usesRasterizer())
+    {
+        // commands so far are drawn, the user then writes over them
+        flushDrawList();
+        pitch = rasterizer->getPitch();
+        return rasterizer->getPixels();
+    }
+
+    if (framebuffer == NULL)
+    {
+        framebuffer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, w, h);
+    }
+
+    void *pixels = NULL;
+    if (framebuffer == NULL || SDL_LockTexture(framebuffer, NULL, &pixels, &pitch) != 0)
+    {
+        return NULL;
+    }
+    return (Uint32 *)pixels;
 }
 
-void Memake::setMousePos()
+void Memake::unlockFramebuffer()
 {
-    SDL_GetMouseState(&mousePosX, &mousePosY);
+    if (threaded)
+    {
+        // commands so far are drawn under the framebuffer, later ones over it
+        std::swap(drawList, recordSlot->lists[0]);
+        configureDrawList(recordSlot->lists[0]);
+        recordSlot->hasFramebuffer = true;
+        return;
+    }
+    if (usesRasterizer())
+    {
+        return;
+    }
+
+    // keep order with commands recorded before
+    flushDrawList();
+    SDL_UnlockTexture(framebuffer);
+    renderCopy(renderer, framebuffer, NULL, NULL);
 }
 
-float Memake::getDeltaTime()
+void Memake::clear()
 {
-    return deltatime;
+    if (usesRasterizer())
+    {
+        // rasterizer clears with the first commands of the frame
+        rasterClearPending = true;
+        return;
+    }
+    setRenderDrawColor(renderer, bgColor.r, bgColor.g, bgColor.b, 0xFF);
+    renderClear(renderer);
 }
 
-void Memake::setDeltaTime()
+void Memake::setSoftwareRaster(bool enabled)
 {
-    prevTime = currentTime;
-    currentTime = SDL_GetTicks();
-    deltatime = (currentTime - prevTime) / 1000.0f;
+    if (!enabled)
+    {
+        if (rasterizer != NULL && rasterizer == softRaster.get())
+        {
+            setRasterizer(NULL);
+        }
+        softRaster.reset();
+        return;
+    }
+    if (softRaster == NULL)
+    {
+        softRaster.reset(new SoftRaster(workerPool.get()));
+        softRaster->setFractalTreeCache(&treeCache);
+    }
+    setRasterizer(softRaster.get());
 }
 
-void Memake::delay(int delay)
+void Memake::setRasterizer(Rasterizer *rasterizer)
 {
-    SDL_Delay(delay);
+    flushDrawList();
+    this->rasterizer = rasterizer;
+    if (rasterizer != NULL)
+    {
+        rasterizer->resize(w, h);
+    }
+    updateDeferred();
 }
 
-void Memake::setScreenBackgroundColor(Color color)
+void Memake::presentRasterizer()
 {
-    bgColor = color;
+    if (rasterTexture == NULL)
+    {
+        rasterTexture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, w, h);
+        if (rasterTexture == NULL)
+        {
+            return;
+        }
+    }
+    const Rasterizer &frame = *rasterizer;
+    updateTexture(rasterTexture, NULL, frame.getPixels(), frame.getPitch());
+    renderCopy(renderer, rasterTexture, NULL, NULL);
 }
 
-Color Memake::generateColor(Uint8 r, Uint8 g, Uint8 b)
+void Memake::setScene(Scene *scene)
 {
-    Color newColor = {r, g, b, 255};
-    return newColor;
+    flushDrawList();
+    this->scene = scene;
+    updateDeferred();
+    if (scene != NULL)
+    {
+        scene->getDirty().setBounds(w, h);
+        scene->invalidate();
+        configureDrawList(sceneList);
+    }
 }
 
-int Memake::getScreenH()
+bool Memake::drawSceneFrame(bool force)
 {
-    return h;
+    DirtyRegion &dirty = scene->getDirty();
+    const bool overlay = !drawList.empty();
+    if (!force && dirty.empty() && !overlay && !sceneOverlay && !scenePresent)
+    {
+        return false;
+    }
+    sceneOverlay = overlay;
+    scenePresent = false;
+
+    if (sceneCanvas == NULL && !sceneNoTargets)
+    {
+        sceneCanvas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, w, h);
+        sceneNoTargets = sceneCanvas == NULL;
+        dirty.addAll();
+    }
+    if (sceneCanvas != NULL)
+    {
+        setRenderTarget(renderer, sceneCanvas);
+    }
+    else
+    {
+        // back buffer isn't kept after present, so without a canvas everything is redrawn
+        dirty.addAll();
+    }
+
+    for (const SDL_Rect &r : dirty.getRects())
+    {
+        renderSetClipRect(renderer, &r);
+        setRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+        setRenderDrawColor(renderer, bgColor.r, bgColor.g, bgColor.b, 0xFF);
+        renderFillRect(renderer, &r);
+        scene->record(sceneList, r);
+        sceneList.flush(renderer, sortByState);
+        sceneList.clear();
+    }
+    renderSetClipRect(renderer, NULL);
+    dirty.clear();
+
+    if (sceneCanvas != NULL)
+    {
+        setRenderTarget(renderer, NULL);
+        renderCopy(renderer, sceneCanvas, NULL, NULL);
+    }
+    flushDrawList();
+    return true;
 }
 
-int Memake::getScreenW()
+bool Memake::beginLayer(const string &name)
 {
-    return w;
+    if (recordedLayer != NULL)
+    {
+        cout << "beginLayer(" << name << ") while another layer is recording, ignored" << endl;
+        return false;
+    }
+
+    std::unique_ptr<Layer> &layer = layers[name];
+    if (layer == NULL)
+    {
+        layer.reset(new Layer(w, h));
+    }
+    if (layer->isRecorded())
+    {
+        drawLayer(layer.get());
+        return false;
+    }
+
+    // frames in flight keep drawing the previous recording, this one goes into another list
+    DrawList &list = layer->beginRecording();
+    configureDrawList(list);
+
+    recordedLayer = layer.get();
+    std::swap(drawList, list);
+    layerPrevDeferred = deferred;
+    deferred = true;
+    return true;
 }
 
-void Memake::close()
+void Memake::endLayer()
 {
-    keepWindowOpen = false;
+    if (recordedLayer == NULL)
+    {
+        return;
+    }
+    std::swap(drawList, recordedLayer->getRecordingList());
+    deferred = layerPrevDeferred;
+    recordedLayer->endRecording();
+    drawLayer(recordedLayer);
+    recordedLayer = NULL;
 }
 
-char Memake::readKeyInput()
+void Memake::drawLayer(Layer *layer)
 {
-    switch (event.type)
+    countPrim(DrawCmdType::Layer);
+    const int recording = layer->getCurrent();
+    if (deferred)
     {
-    case SDL_TEXTINPUT:
-        for (int i = 0; i < SDL_TEXTINPUTEVENT_TEXT_SIZE; ++i)
-        {
-            char c = event.text.text[i];
-            // cancel if a non-ascii char is encountered
-            if (c < ' ' || c > '~')
-            {
-                break;
-            }
-            else
-            {
-                return c;
-            }
-        }
-        break;
+        // the recording isn't reused until the frame holding it is drawn
+        layer->addRef(recording);
+        (threaded ? recordSlot->layerRefs : layerRefs).push_back({layer, recording});
+        drawList.addLayer(layer, recording);
+        return;
     }
-    return ' ';
+    layer->draw(renderer, sortByState, layer->getList(recording), layer->getSerial(recording));
 }
 
-void Memake::update(std::function<void()> draw)
+void Memake::releaseLayerRefs(vector<std::pair<Layer *, int>> &refs)
 {
-    while (keepWindowOpen)
+    for (const auto &ref : refs)
     {
-        setMousePos();
-        setDeltaTime();
-
-        while (SDL_PollEvent(&event))
-        {
-            if (event.type == SDL_QUIT)
-            {
-                keepWindowOpen = false;
-            }
-            else if (event.type == SDL_KEYDOWN)
-            {
-                if (event.key.keysym.sym == SDLK_ESCAPE)
-                {
-                    keepWindowOpen = false;
-                }
-            }
-        }
-
-        clear();
-
-        // compose(); // set this to active to use unwrap wraper
-        draw();
+        ref.first->releaseRef(ref.second);
+    }
+    refs.clear();
+}
 
-        SDL_RenderPresent(renderer);
+void Memake::invalidateLayer(const string &name)
+{
+    auto it = layers.find(name);
+    if (it != layers.end())
+    {
+        it->second->setRecorded(false);
     }
 }
 
-void Memake::clear()
+void Memake::invalidateLayers()
 {
-    SDL_SetRenderDrawColor(renderer, bgColor.r, bgColor.g, bgColor.b, 0xFF);
-    SDL_RenderClear(renderer);
+    for (auto &it : layers)
+    {
+        it.second->setRecorded(false);
+    }
 }
 
 // Debugger | Testing
@@ -217,103 +1279,322 @@ void Memake::compose()
 
 void Memake::drawRect(int x, int y, int width, int height, Color color)
 {
+    countPrim(DrawCmdType::Rect);
+    if (!isVisible(SDL_min(x, x + width), SDL_min(y, y + height), SDL_max(x, x + width), SDL_max(y, y + height)))
+    {
+        return;
+    }
+    if (deferred)
+    {
+        drawList.addRect(x, y, width, height, color);
+        return;
+    }
+
     Rectangle rect(x, y, width, height);
     rect.Draw(renderer, color);
 }
 
 void Memake::drawCircle(int x, int y, int radius, Color color)
 {
+    countPrim(DrawCmdType::Ellipse);
+    if (!isVisible(x - radius, y - radius, x + radius, y + radius))
+    {
+        return;
+    }
+    if (deferred)
+    {
+        drawList.addEllipse(x, y, radius, radius, color);
+        return;
+    }
+
+    if (circleSprites && circleAtlas.draw(renderer, x, y, radius, circleAntialias, color))
+    {
+        return;
+    }
+
     Circle circ(x, y, radius);
     circ.Draw(renderer, color);
 }
 
-void Memake::drawLine(int x1, int y1, int x2, int y2, Color color)
+void Memake::drawCircles(const Vector2 *centers, int count, int radius, Color color)
+{
+    if (!deferred && circleSprites && circleAtlas.drawMany(renderer, centers, count, radius, circleAntialias, color))
+    {
+        countPrim(DrawCmdType::Ellipse, count);
+        return;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        drawCircle(centers[i].x, centers[i].y, radius, color);
+    }
+}
+
+void Memake::drawCircles(const float *x, const float *y, const float *r, const Color *colors, size_t n)
+{
+    countPrim(DrawCmdType::Ellipse, (int)n);
+    bulkList().addCircles(x, y, r, colors, n);
+    endBulk();
+}
+
+void Memake::drawLines(const float *x1, const float *y1, const float *x2, const float *y2, const Color *colors, size_t n,
+                       bool antialias)
+{
+    countPrim(antialias ? DrawCmdType::AALine : DrawCmdType::Line, (int)n);
+    bulkList().addLines(x1, y1, x2, y2, colors, n, antialias);
+    endBulk();
+}
+
+void Memake::drawRects(const float *x, const float *y, const float *width, const float *height, const Color *colors,
+                       size_t n)
+{
+    countPrim(DrawCmdType::Rect, (int)n);
+    bulkList().addRects(x, y, width, height, colors, n);
+    endBulk();
+}
+
+void Memake::drawDots(const float *x, const float *y, const Color *colors, size_t n)
 {
+    countPrim(DrawCmdType::Dot, (int)n);
+    bulkList().addDots(x, y, colors, n);
+    endBulk();
+}
+
+void Memake::endBulk()
+{
+    if (!deferred)
+    {
+        // in submission order, runs of one color are one batch
+        immediateList.flush(renderer);
+        immediateList.clear();
+    }
+}
+
+void Memake::drawLine(int x1, int y1, int x2, int y2, Color color, bool antialias)
+{
+    countPrim(antialias ? DrawCmdType::AALine : DrawCmdType::Line);
+    if (!isVisible(SDL_min(x1, x2) - 1, SDL_min(y1, y2) - 1, SDL_max(x1, x2) + 1, SDL_max(y1, y2) + 1))
+    {
+        return;
+    }
+    if (deferred)
+    {
+        if (antialias)
+        {
+            drawList.addAALine(x1, y1, x2, y2, color);
+        }
+        else
+        {
+            drawList.addLine(x1, y1, x2, y2, color);
+        }
+        return;
+    }
+
     Line line(x1, y1, x2, y2);
-    line.Draw(renderer, color);
+    if (antialias)
+    {
+        line.DrawAntialiased(renderer, color);
+    }
+    else
+    {
+        line.Draw(renderer, color);
+    }
 }
 
 void Memake::drawEllipse(int x, int y, int rx, int ry, Color color)
 {
+    countPrim(DrawCmdType::Ellipse);
+    if (!isVisible(x - rx, y - ry, x + rx, y + ry))
+    {
+        return;
+    }
+    if (deferred)
+    {
+        drawList.addEllipse(x, y, rx, ry, color);
+        return;
+    }
+
+    if (rx == ry && circleSprites && circleAtlas.draw(renderer, x, y, rx, circleAntialias, color))
+    {
+        return;
+    }
+
     Ellipse ellipse(x, y, rx, ry);
     ellipse.Draw(renderer, color);
 }
 
 void Memake::drawDot(int x, int y, Color color)
 {
+    countPrim(DrawCmdType::Dot);
+    if (!isVisible(x, y, x, y))
+    {
+        return;
+    }
+    if (deferred)
+    {
+        drawList.addDot(x, y, color);
+        return;
+    }
+
     Dot dot(x, y);
     dot.Draw(renderer, color);
 }
 
 void Memake::drawTriangle(int x1, int y1, int x2, int y2, int x3, int y3, Color color)
 {
+    countPrim(DrawCmdType::Polygon);
+    if (!isVisible(SDL_min(x1, SDL_min(x2, x3)), SDL_min(y1, SDL_min(y2, y3)), SDL_max(x1, SDL_max(x2, x3)),
+                   SDL_max(y1, SDL_max(y2, y3))))
+    {
+        return;
+    }
+    if (deferred)
+    {
+        int vx[3] = {x1, x2, x3};
+        int vy[3] = {y1, y2, y3};
+        drawList.addPolygon(vx, vy, 3, color);
+        return;
+    }
+
     Triangle triangle(x1, y1, x2, y2, x3, y3);
     triangle.Draw(renderer, color);
 }
 
 void Memake::drawTrapezoid(int x1, int y1, int x2, int y2, int x3, int y3, int x4, int y4, Color color)
 {
+    countPrim(DrawCmdType::Polygon);
+    if (!isVisible(SDL_min(SDL_min(x1, x2), SDL_min(x3, x4)), SDL_min(SDL_min(y1, y2), SDL_min(y3, y4)),
+                   SDL_max(SDL_max(x1, x2), SDL_max(x3, x4)), SDL_max(SDL_max(y1, y2), SDL_max(y3, y4))))
+    {
+        return;
+    }
+    if (deferred)
+    {
+        int vx[4] = {x1, x2, x3, x4};
+        int vy[4] = {y1, y2, y3, y4};
+        drawList.addPolygon(vx, vy, 4, color);
+        return;
+    }
+
     Trapezoid trapezoid(x1, y1, x2, y2, x3, y3, x4, y4);
     trapezoid.Draw(renderer, color);
 }
 
 void Memake::drawPolygon(Vector2 *edgesPos, int numOfEdges, Color color)
 {
+    countPrim(DrawCmdType::Polygon);
+    if (numOfEdges > 0)
+    {
+        // vertices truncate to pixels like DrawList::addPolygon takes them
+        int x0 = (int)edgesPos[0].x, y0 = (int)edgesPos[0].y, x1 = x0, y1 = y0;
+        for (int i = 1; i < numOfEdges; i++)
+        {
+            x0 = SDL_min(x0, (int)edgesPos[i].x);
+            y0 = SDL_min(y0, (int)edgesPos[i].y);
+            x1 = SDL_max(x1, (int)edgesPos[i].x);
+            y1 = SDL_max(y1, (int)edgesPos[i].y);
+        }
+        if (!isVisible(x0, y0, x1, y1))
+        {
+            return;
+        }
+    }
+    if (deferred)
+    {
+        drawList.addPolygon(edgesPos, numOfEdges, color);
+        return;
+    }
+
     Polygon polygon(edgesPos, numOfEdges);
     polygon.Draw(renderer, color);
 }
 
 void Memake::drawPolkadot(int x1, int y1, int x2, int y2)
 {
-    Polkadot polkadot(x1, y1, x2, y2);
-    polkadot.Draw(renderer);
+    countPrim(DrawCmdType::Polkadot);
+    // the pattern is positional, a cut region shows the same pixels
+    x1 = SDL_max(x1, 0);
+    y1 = SDL_max(y1, 0);
+    x2 = SDL_min(x2, w);
+    y2 = SDL_min(y2, h);
+    if (x1 >= x2 || y1 >= y2)
+    {
+        return;
+    }
+    if (deferred)
+    {
+        drawList.addPolkadot(x1, y1, x2, y2);
+        return;
+    }
+
+    polkadotCache.draw(renderer, x1, y1, x2, y2);
 }
 
 void Memake::drawFlower(int x, int y, int petalSize, int petalDistance, Color petalColor, Color centerPetalColor)
 {
-    Ellipse upperLeftPetal(x - petalDistance, y - petalDistance, petalSize, petalSize);
-    upperLeftPetal.Draw(renderer, petalColor);
-
-    Ellipse upperRightPetal(x + petalDistance, y - petalDistance, petalSize, petalSize);
-    upperRightPetal.Draw(renderer, petalColor);
-
-    Ellipse lowerLeft(x - petalDistance, y + petalDistance, petalSize, petalSize);
-    lowerLeft.Draw(renderer, petalColor);
-
-    Ellipse lowerRight(x + petalDistance, y + petalDistance, petalSize, petalSize);
-    lowerRight.Draw(renderer, petalColor);
-
-    Ellipse middlePetal(x, y, petalSize, petalSize);
-    middlePetal.Draw(renderer, centerPetalColor);
+    drawEllipse(x - petalDistance, y - petalDistance, petalSize, petalSize, petalColor);
+    drawEllipse(x + petalDistance, y - petalDistance, petalSize, petalSize, petalColor);
+    drawEllipse(x - petalDistance, y + petalDistance, petalSize, petalSize, petalColor);
+    drawEllipse(x + petalDistance, y + petalDistance, petalSize, petalSize, petalColor);
+    drawEllipse(x, y, petalSize, petalSize, centerPetalColor);
 }
 
 void Memake::drawEllipseBorder(int x, int y, int rx, int ry, Color color)
 {
+    countPrim(DrawCmdType::EllipseBorder);
+    if (!isVisible(x - rx, y - ry, x + rx, y + ry))
+    {
+        return;
+    }
+    if (deferred)
+    {
+        drawList.addEllipseBorder(x, y, rx, ry, color);
+        return;
+    }
+
     EllipseBorder ellipseBorder(x, y, rx, ry);
     ellipseBorder.Draw(renderer, color);
 }
 
 void Memake::drawPaddle(int x, int y, int width, int height, Color barColor, Color cornerColor)
 {
-    Rectangle rect(x, y, width, height);
-    Ellipse rPaddle(x, y + (height / 2), height / 2, height / 2);
-    Ellipse lPaddle(x + width, y + (height / 2), height / 2, height / 2);
-
-    lPaddle.Draw(renderer, cornerColor);
-    rPaddle.Draw(renderer, cornerColor);
-    rect.Draw(renderer, barColor);
+    drawEllipse(x + width, y + (height / 2), height / 2, height / 2, cornerColor);
+    drawEllipse(x, y + (height / 2), height / 2, height / 2, cornerColor);
+    drawRect(x, y, width, height, barColor);
 }
 
 void Memake::drawRadar(int x, int y, int radius, int count, Color color)
 {
-    for (int i = 1; i <= count; i++)
+    countPrim(DrawCmdType::EllipseBorder, count);
+    // the outermost ring bounds all of them
+    const int outerR = count * radius;
+    if (count <= 0 || !isVisible(x - outerR, y - outerR, x + outerR, y + outerR))
+    {
+        return;
+    }
+    if (deferred)
     {
-        drawEllipseBorder(x, y, i * radius, i * radius, color);
+        for (int i = 1; i <= count; i++)
+        {
+            if (isVisible(x - i * radius, y - i * radius, x + i * radius, y + i * radius))
+            {
+                drawList.addEllipseBorder(x, y, i * radius, i * radius, color);
+            }
+        }
+        return;
     }
+
+    borderEllipseRings(renderer, x, y, radius, count, color);
 }
 
 void Memake::drawFractalTree(int x, int y, int lineLength, int lineLengthSeed, int angle, int angleSeed, Color color)
 {
-    FractalTree ft(x, y, lineLength, lineLengthSeed, angle, angleSeed);
-    ft.Draw(renderer, color);
+    countPrim(DrawCmdType::FractalTree);
+    if (deferred)
+    {
+        drawList.addFractalTree(x, y, lineLength, lineLengthSeed, angle, angleSeed, color);
+        return;
+    }
+
+    treeCache.draw(renderer, {x, y, lineLength, lineLengthSeed, angle, angleSeed}, color);
 }
@@ -17,14 +17,80 @@
 #include "Polygon.h"
 #include "Polkadot.h"
 #include "FractalTree.h"
+#include "DrawList.h"
+#include "CircleAtlas.h"
+#include "FrameArena.h"
+#include "PolkadotCache.h"
+#include "FractalTreeCache.h"
+#include "WorkerPool.h"
+#include "Layer.h"
+#include "Scene.h"
+#include "SoftRaster.h"
+#include "RenderCalls.h"
+#include "FrameCapture.h"
+#include <memory>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
 
 using namespace std;
 
+/**
+ * How update() paces frames.
+ */
+enum class FramePacing
+{
+    Uncapped, // run as fast as possible, for benchmarks
+    VSync,    // present waits for display refresh, falls back to FixedFps at refresh rate if unavailable
+    FixedFps, // sleep then spin on the high resolution counter until the next frame is due
+};
+
+/**
+ * Settings of a windowed Memake.
+ */
+struct WindowOptions
+{
+    FramePacing pacing = FramePacing::Uncapped;
+    int targetFps = 60;  // FixedFps target
+    string renderDriver; // SDL render driver name, e.g. "direct3d11", "opengl", "software"; empty picks the best one
+};
+
+/**
+ * Settings of a Memake without window: software renderer onto a surface, works with the SDL dummy video driver.
+ */
+struct OffscreenOptions
+{
+    int frameCnt = 100;            // update() returns after this many frames
+    string dumpPrefix;             // if set, frames are saved as <dumpPrefix>00000.bmp, ...
+    int dumpEvery = 1;             // save every Nth frame only
+    float deltaTime = 1.f / 60.f;  // fixed getDeltaTime(), so runs are reproducible
+    bool printFrameTimes = true;   // print draw time statistics when update() returns
+    unsigned int workerCnt = 0;    // threads of the tile rasterizer and tree cache, 0 uses every core
+};
+
+/**
+ * Counters and timings of one frame, see Memake::getFrameStats().
+ */
+struct FrameStats
+{
+    Uint64 frame = 0;                 // number of the frame, from 0
+    int sdlCalls = 0;                 // SDL render calls: fills, lines, points, copies, state changes, uploads, present
+    int prims[k_drawCmdTypeCnt] = {}; // draw calls by DrawCmdType, shapes like flowers count as their parts
+    Uint64 pixels = 0;                // pixels filled by SDL calls as submitted, a rasterizer's frame counts as one copy
+    float clearMs = 0;
+    float drawMs = 0;                 // user draw function and draw list flush
+    float presentMs = 0;              // rasterizer upload, offscreen frame end and SDL_RenderPresent
+};
+
 class Memake
 {
     public:
         Memake(int width, int height, string window_name);
         Memake(int width, int height, string window_name, Color backgroundColor);
+        Memake(int width, int height, string window_name, const WindowOptions &options, Color backgroundColor = {0x0, 0x0, 0x0, 0xFF});
+        Memake(int width, int height, const OffscreenOptions &offscreen, Color backgroundColor = {0x0, 0x0, 0x0, 0xFF});
         ~Memake();
 
         /**
@@ -38,6 +104,11 @@ class Memake
          */
         char readKeyInput();
 
+        /**
+         * Check if key is held down right now, e.g. isKeyDown(SDLK_LEFT)
+         */
+        bool isKeyDown(SDL_Keycode key);
+
         /**
          * Get max screen width
          */
@@ -58,6 +129,61 @@ class Memake
          */
         void delay(int delay);
 
+        /**
+         * Run SDL rendering and present on a render thread while the next frame is recorded.
+         * The user draw function records into a command list (deferred drawing is forced), finished lists are handed to
+         * the render thread, which owns a renderer created for it. maxFrameLatency is how many frames recording may run
+         * ahead of the one being rendered, 1 is double buffering.
+         * Not available offscreen, and only where the platform allows rendering off the main thread (not macOS).
+         */
+        void setRenderThread(bool enabled, int maxFrameLatency = 1);
+
+        /**
+         * Change frame pacing, VSync works only if the renderer was created with it (see WindowOptions).
+         * With the render thread the change applies from the next submitted frame.
+         */
+        void setFramePacing(FramePacing pacing, int targetFps = 60);
+
+        /**
+         * Name of the SDL render driver in use.
+         */
+        const char *getRendererName();
+
+        /**
+         * Counters and timings of the last finished frame: SDL render calls, draw calls by primitive, pixels filled,
+         * and time spent in clear, the user draw function and present. With the render thread the SDL counters, clear
+         * and present are of the last frame it rendered, draw time is recording plus its draw list flush.
+         */
+        const FrameStats &getFrameStats();
+
+        /**
+         * Draw a graph of the last frames' clear, draw and present times (blue, green, orange) in the top left corner,
+         * the white line is the frame budget at the target fps. Its own SDL calls aren't counted.
+         * Not drawn with the render thread.
+         */
+        void setStatsOverlay(bool enabled);
+
+        /**
+         * Append FrameStats averaged over every periodFrames frames to a CSV file, empty path stops logging.
+         * Returns false if the file can't be opened.
+         */
+        bool setStatsLog(const string &path, int periodFrames = 60);
+
+        /**
+         * Save every presented frame (without the stats overlay) as <prefix>00000.bmp, ... or headerless .raw files.
+         * Frames are read back into bufferCnt reusable buffers and written by a background thread,
+         * when all buffers are still queued the frame is dropped instead of waited for. Empty prefix stops capturing
+         * after the queued frames are written.
+         */
+        void setFrameCapture(const string &prefix, FrameCapture::Format format = FrameCapture::Format::Bmp,
+                             int bufferCnt = 4);
+        const FrameCapture &getFrameCapture() const { return frameCapture; }
+
+        /**
+         * Print frame count, mean frame interval, its deviation, min, max and frames late by half a frame or more.
+         */
+        void printFrameJitter();
+
         /**
          * Return Delta Time of the framerate. useful to multiply with any movement speed to get consistent movement through out all display.
          */
@@ -78,6 +204,65 @@ class Memake
          */
         void setScreenBackgroundColor(Color color);
 
+        /**
+         * Record draw calls and issue them batched after the user draw function returns.
+         * With sortByState commands are also grouped by color, so overlapping shapes of different color may change order.
+         */
+        void setDeferredDrawing(bool enabled, bool sortByState = false);
+
+        /**
+         * Draw circles as color modulated copies of pre-rasterized sprites instead of filled spans.
+         * Enabled by default on accelerated renderers, radius above CircleAtlas::k_maxRadius still uses spans.
+         */
+        void setCircleSprites(bool enabled, bool antialias = false);
+
+        /**
+         * Keep fractal trees rasterized in textures, so a tree drawn with the same arguments every frame costs one copy.
+         * Tree geometry is always cached, this only adds the texture.
+         * With the render thread the cache belongs to it, the change applies from the next submitted frame.
+         */
+        void setFractalTreeTextures(bool enabled);
+
+        /**
+         * Record following draw calls into a static layer, rendered to a texture once and composited every frame
+         * at this point of the frame. Returns false when the layer is cached, its draw calls are then skipped:
+         *     if (mmk.beginLayer("background")) { ...draw calls...; mmk.endLayer(); }
+         * Everything drawn outside of layers stays dynamic and is drawn every frame.
+         */
+        bool beginLayer(const string &name);
+
+        /**
+         * End recording of the layer started by beginLayer().
+         */
+        void endLayer();
+
+        /**
+         * Make beginLayer() record the layer again, e.g. when what it shows moved.
+         */
+        void invalidateLayer(const string &name);
+        void invalidateLayers();
+
+        /**
+         * Retained mode: draw the scene's shapes into a kept canvas, and each frame clear and redraw only the area
+         * damaged by changed shapes. The user draw function updates the scene, its own draw calls go over it
+         * (deferred drawing is forced). Frames with no damage and no draw calls aren't drawn nor presented,
+         * the loop waits for events then. NULL goes back to redrawing everything. Not used with the render thread.
+         */
+        void setScene(Scene *scene);
+
+        /**
+         * Rasterize all draw calls on the CPU: commands are binned into SoftRaster::k_tileSize screen tiles which
+         * the worker pool fills in parallel, the frame is shown with one streaming texture upload.
+         * Deferred drawing is forced. Not used with the render thread or a scene.
+         */
+        void setSoftwareRaster(bool enabled);
+
+        /**
+         * Rasterize frames with the given rasterizer instead of the SDL renderer, e.g. an OpenCL one.
+         * Same as setSoftwareRaster otherwise, NULL goes back to the SDL renderer. Memake doesn't own the rasterizer.
+         */
+        void setRasterizer(Rasterizer *rasterizer);
+
         /**
          * Generate Color by given (red, green, blue) values.
          */
@@ -93,10 +278,28 @@ class Memake
          */
         void drawCircle(int x, int y, int radius, Color color);
 
+        /**
+         * Draw same size Circles at every center of the given Array of Vec2.
+         */
+        void drawCircles(const Vector2 *centers, int count, int radius, Color color);
+
+        /**
+         * Bulk drawing from structure of arrays: element i is drawn with x[i], y[i], ... and colors[i].
+         * Same result as calling drawCircle / drawLine / drawRect / drawDot for every element (coordinates truncated),
+         * but elements go straight into the draw list, immediate mode flushes them batched by color.
+         */
+        void drawCircles(const float *x, const float *y, const float *r, const Color *colors, size_t n);
+        void drawLines(const float *x1, const float *y1, const float *x2, const float *y2, const Color *colors, size_t n,
+                       bool antialias = false);
+        void drawRects(const float *x, const float *y, const float *width, const float *height, const Color *colors,
+                       size_t n);
+        void drawDots(const float *x, const float *y, const Color *colors, size_t n);
+
         /**
          * Draw Straight Line from given (x1,y1) to (x2, y2) values.
+         * With antialias the line is blended by pixel coverage (Wu's algorithm), lines are batched by alpha level.
          */
-        void drawLine(int x1, int y1, int x2, int y2, Color color);
+        void drawLine(int x1, int y1, int x2, int y2, Color color, bool antialias = false);
 
         /**
          * Draw Ellipse/Custom Cirle with a given (x,y) and (rx,ry) or custom radius values.
@@ -161,11 +364,66 @@ class Memake
          */
         void drawFractalTree(int x, int y, int lineLength, int lineLengthSeed, int angle, int angleSeed, Color color);
 
+        /**
+         * Check if Memake renders offscreen, without window.
+         */
+        bool isOffscreen();
+
+        /**
+         * Draw time of every frame run so far in milliseconds: clear, user draw function and deferred draw list,
+         * measured after the renderer finished. Recorded in offscreen mode only.
+         */
+        const vector<float> &getFrameTimesMs();
+
+        /**
+         * Print frame count and average, min, median, 95th, 99th percentile and max draw times.
+         */
+        void printFrameTimes();
+
+        /**
+         * Lock screen sized ARGB8888 framebuffer for direct pixel writes.
+         * Memory is write only and must be fully written, it's drawn over the screen by unlockFramebuffer().
+         */
+        Uint32 *lockFramebuffer(int &pitch);
+
+        /**
+         * Upload framebuffer locked by lockFramebuffer() and draw it.
+         */
+        void unlockFramebuffer();
+
     private:
         void clear();
         void compose();
         void setMousePos();
         void setDeltaTime();
+        void flushDrawList();
+        void initCircleSprites();
+        void initCaches();
+        void endOffscreenFrame(Uint64 drawBeg);
+        void createRenderer(const WindowOptions &options);
+        void applyFramePacing(FramePacing pacing, int targetFps);
+        void configureDrawList(DrawList &list);
+        void releaseRendererResources();
+        void beginRecordedFrame();
+        void submitRecordedFrame();
+        void waitRenderedFrames();
+        void renderThreadLoop();
+        void drawLayer(Layer *layer);
+        void releaseLayerRefs(vector<std::pair<Layer *, int>> &refs);
+        bool drawSceneFrame(bool force);
+        void updateDeferred();
+        bool usesRasterizer() const { return rasterizer != NULL && !threaded && scene == NULL; }
+        void presentRasterizer();
+        void paceFrame();
+        void countPrim(DrawCmdType type, int cnt = 1) { curStats.prims[(int)type] += cnt; }
+        // inclusive bounds against the window, draw calls return before recording or rasterizing when false
+        bool isVisible(int x0, int y0, int x1, int y1) const { return boundsVisible(x0, y0, x1, y1, {0, 0, w, h}); }
+        DrawList &bulkList() { return deferred ? drawList : immediateList; }
+        void endBulk();
+        void endFrameStats();
+        void drawStatsOverlay();
+        void captureFrame();
+        void writeStatsLog();
 
     private:
         SDL_Renderer *GetRenderer();
@@ -174,6 +432,7 @@ class Memake
         SDL_Renderer *renderer = NULL;
         SDL_Window   *window = NULL;
         SDL_Surface  *surface = NULL;
+        SDL_Texture  *framebuffer = NULL;
         SDL_Event event;
 
         int w;
@@ -184,4 +443,92 @@ class Memake
         float deltatime;
         bool keepWindowOpen = true;
         Color bgColor;
+
+        DrawList drawList;
+        DrawList immediateList; // bulk draw calls without deferred drawing
+        bool deferred = false;
+        bool sortByState = false;
+
+        CircleAtlas circleAtlas;
+        bool circleSprites = false;
+        bool circleAntialias = false;
+
+        PolkadotCache polkadotCache;
+        FractalTreeCache treeCache;
+        std::unique_ptr<WorkerPool> workerPool;
+
+        map<string, std::unique_ptr<Layer>> layers;
+        Layer *recordedLayer = NULL;
+        vector<std::pair<Layer *, int>> layerRefs; // layer recordings of the frame, without render thread
+        bool layerPrevDeferred = false;
+
+        Scene *scene = NULL;
+        DrawList sceneList;
+        SDL_Texture *sceneCanvas = NULL;
+        bool sceneNoTargets = false;
+        bool sceneOverlay = false; // last frame had draw calls over the scene
+        bool scenePresent = false; // window needs the frame again
+
+        std::unique_ptr<SoftRaster> softRaster;
+        Rasterizer *rasterizer = NULL;
+        SDL_Texture *rasterTexture = NULL;
+        bool rasterClearPending = false;
+
+        bool offscreen = false;
+        OffscreenOptions offscreenOptions;
+        vector<float> frameTimesMs;
+
+        // recorded frame handed to the render thread: commands before and after the framebuffer
+        struct FrameSlot
+        {
+            DrawList lists[2];
+            bool hasFramebuffer = false;
+            vector<Uint32> pixels;
+            Color bgColor;
+            bool sortByState = false;
+            // settings of render thread owned state, applied there before the frame is drawn
+            FramePacing pacing = FramePacing::Uncapped;
+            int targetFps = 60;
+            bool treeTextures = false;
+            vector<std::pair<Layer *, int>> layerRefs; // layer recordings the frame draws
+        };
+
+        bool threaded = false;
+        bool userDeferred = false;
+        WindowOptions windowOptions;
+        std::thread renderThread;
+        std::mutex frameMtx;
+        std::condition_variable frameCv;
+        vector<std::unique_ptr<FrameSlot>> frameSlots;
+        std::deque<FrameSlot *> freeSlots;
+        std::deque<FrameSlot *> queuedSlots;
+        FrameSlot *recordSlot = NULL;
+        bool renderThreadStop = false;
+        bool renderThreadReady = false;
+
+        FramePacing pacing = FramePacing::Uncapped;
+        int targetFps = 60;
+        bool treeTextures = false; // requested, treeCache follows it on the thread owning the renderer
+        Uint64 nextFrameTicks = 0;
+        Uint64 lastFrameTicks = 0;
+
+        FrameStats curStats;      // frame being drawn
+        FrameStats frameStats;    // last finished frame
+        FrameStats renderedStats; // last frame of the render thread, guarded by frameMtx
+        static const int k_statsHistoryCnt = 120;
+        bool statsOverlay = false;
+        vector<FrameStats> statsHistory; // overlay graph, ring buffer of k_statsHistoryCnt frames
+        size_t statsHistoryPos = 0;
+        vector<SDL_Rect> overlayRects;
+        FILE *statsLog = NULL;
+        FrameCapture frameCapture;
+        int statsLogPeriod = 60;
+        FrameStats statsSum;
+        int statsSumCnt = 0;
+
+        // frame interval statistics, ms
+        int intervalCnt = 0;
+        int lateCnt = 0;
+        double intervalSum = 0, intervalSqSum = 0;
+        double intervalMin = 0, intervalMax = 0;
 };
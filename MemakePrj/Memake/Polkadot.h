@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Memake.h"
+#include "SpanFill.h"
 
 class Polkadot
 {
@@ -13,15 +14,92 @@ public:
         this->y2 = y2;
     }
 
-    void Draw(SDL_Renderer *renderer)
+    int GetWidth() const { return x2 > x1 ? x2 - x1 : 0; }
+    int GetHeight() const { return y2 > y1 ? y2 - y1 : 0; }
+
+    /**
+     * Write the pattern as ARGB8888 pixels, pitch in bytes.
+     * Channels are squared distances to (25, 25), (50, 50) and (75, 75) truncated to 8 bits,
+     * so 16 bit math gives the same low byte and SSE2 does 8 pixels at once.
+     */
+    void Fill(Uint32 *pixels, int pitch) const
     {
+        const int w = GetWidth();
         for (int _y = y1; _y < y2; _y++)
         {
-            for (int _x = x1; _x < x2; _x++)
+            Uint32 *row = (Uint32 *)((Uint8 *)pixels + (_y - y1) * pitch);
+            const int ry = (_y - 25) * (_y - 25);
+            const int gy = (_y - 50) * (_y - 50);
+            const int by = (_y - 75) * (_y - 75);
+            int i = 0;
+#ifdef MEMAKE_SSE2
+            const __m128i lane = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+            const __m128i mask = _mm_set1_epi16(0xFF);
+            const __m128i alpha = _mm_set1_epi16((short)0xFF00);
+            const __m128i ryv = _mm_set1_epi16((short)ry);
+            const __m128i gyv = _mm_set1_epi16((short)gy);
+            const __m128i byv = _mm_set1_epi16((short)by);
+            for (; i + 8 <= w; i += 8)
             {
-                SDL_SetRenderDrawColor(renderer, (_x - 25) * (_x - 25) + (_y - 25) * (_y - 25), (_x - 50) * (_x - 50) + (_y - 50) * (_y - 50), (_x - 75) * (_x - 75) + (_y - 75) * (_y - 75), 255);
-                SDL_RenderDrawPoint(renderer, _x, _y);
+                const __m128i x = _mm_add_epi16(_mm_set1_epi16((short)(x1 + i)), lane);
+                const __m128i dr = _mm_sub_epi16(x, _mm_set1_epi16(25));
+                const __m128i dg = _mm_sub_epi16(x, _mm_set1_epi16(50));
+                const __m128i db = _mm_sub_epi16(x, _mm_set1_epi16(75));
+                const __m128i r = _mm_and_si128(_mm_add_epi16(_mm_mullo_epi16(dr, dr), ryv), mask);
+                const __m128i g = _mm_and_si128(_mm_add_epi16(_mm_mullo_epi16(dg, dg), gyv), mask);
+                const __m128i b = _mm_and_si128(_mm_add_epi16(_mm_mullo_epi16(db, db), byv), mask);
+                // low half g << 8 | b, high half 0xFF << 8 | r
+                const __m128i lo = _mm_or_si128(_mm_slli_epi16(g, 8), b);
+                const __m128i hi = _mm_or_si128(alpha, r);
+                _mm_storeu_si128((__m128i *)(row + i), _mm_unpacklo_epi16(lo, hi));
+                _mm_storeu_si128((__m128i *)(row + i + 4), _mm_unpackhi_epi16(lo, hi));
             }
+#endif
+            for (; i < w; i++)
+            {
+                const int _x = x1 + i;
+                const Uint8 r = (_x - 25) * (_x - 25) + ry;
+                const Uint8 g = (_x - 50) * (_x - 50) + gy;
+                const Uint8 b = (_x - 75) * (_x - 75) + by;
+                row[i] = 0xFF000000 | ((Uint32)r << 16) | ((Uint32)g << 8) | b;
+            }
+        }
+    }
+
+    /**
+     * Create texture with the pattern, NULL for empty region.
+     */
+    SDL_Texture *CreateTexture(SDL_Renderer *renderer) const
+    {
+        const int w = GetWidth();
+        const int h = GetHeight();
+        if (w == 0 || h == 0)
+        {
+            return NULL;
+        }
+
+        SDL_Texture *texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, w, h);
+        if (texture == NULL)
+        {
+            return NULL;
+        }
+        std::vector<Uint32> pixels(w * h);
+        Fill(pixels.data(), w * sizeof(Uint32));
+        updateTexture(texture, NULL, pixels.data(), w * sizeof(Uint32));
+        return texture;
+    }
+
+    /**
+     * Draw with a throwaway texture, use PolkadotCache to draw the same region every frame.
+     */
+    void Draw(SDL_Renderer *renderer)
+    {
+        SDL_Texture *texture = CreateTexture(renderer);
+        if (texture != NULL)
+        {
+            SDL_Rect dst = {x1, y1, GetWidth(), GetHeight()};
+            renderCopy(renderer, texture, NULL, &dst);
+            SDL_DestroyTexture(texture);
         }
     }
 
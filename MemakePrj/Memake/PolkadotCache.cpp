@@ -0,0 +1,63 @@
+#include "PolkadotCache.h"
+#include "Polkadot.h"
+
+PolkadotCache::~PolkadotCache()
+{
+    release();
+}
+
+void PolkadotCache::release()
+{
+    for (auto &it : entries)
+    {
+        SDL_DestroyTexture(it.second.texture);
+    }
+    entries.clear();
+    owner = NULL;
+}
+
+void PolkadotCache::draw(SDL_Renderer *renderer, int x1, int y1, int x2, int y2)
+{
+    if (x2 <= x1 || y2 <= y1)
+    {
+        return;
+    }
+    if (owner != renderer)
+    {
+        release();
+        owner = renderer;
+    }
+
+    const Key key = {x1, y1, x2, y2};
+    auto it = entries.find(key);
+    if (it == entries.end())
+    {
+        SDL_Texture *texture = Polkadot(x1, y1, x2, y2).CreateTexture(renderer);
+        if (texture == NULL)
+        {
+            return;
+        }
+        it = entries.emplace(key, Entry{texture, frame}).first;
+    }
+    it->second.lastFrame = frame;
+
+    SDL_Rect dst = {x1, y1, x2 - x1, y2 - y1};
+    renderCopy(renderer, it->second.texture, NULL, &dst);
+}
+
+void PolkadotCache::endFrame()
+{
+    for (auto it = entries.begin(); it != entries.end();)
+    {
+        if (it->second.lastFrame != frame)
+        {
+            SDL_DestroyTexture(it->second.texture);
+            it = entries.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    ++frame;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <unordered_map>
+#include <SDL.h>
+
+/**
+ * Polkadot pattern textures cached by region.
+ * A region is generated and uploaded once, later frames draw it with a single SDL_RenderCopy.
+ * Regions not drawn during the last frame are dropped by endFrame(), so a moving region costs one upload per change.
+ */
+class PolkadotCache
+{
+public:
+    ~PolkadotCache();
+
+    /**
+     * Drop all textures, must be called before the renderer is destroyed.
+     */
+    void release();
+
+    void draw(SDL_Renderer *renderer, int x1, int y1, int x2, int y2);
+
+    /**
+     * Evict textures not drawn since the previous endFrame().
+     */
+    void endFrame();
+
+private:
+    struct Key
+    {
+        int x1, y1, x2, y2;
+        bool operator==(const Key &o) const { return x1 == o.x1 && y1 == o.y1 && x2 == o.x2 && y2 == o.y2; }
+    };
+    struct KeyHash
+    {
+        size_t operator()(const Key &k) const
+        {
+            size_t h = (size_t)k.x1;
+            h = h * 31 + (size_t)k.y1;
+            h = h * 31 + (size_t)k.x2;
+            return h * 31 + (size_t)k.y2;
+        }
+    };
+    struct Entry
+    {
+        SDL_Texture *texture;
+        unsigned int lastFrame;
+    };
+
+    std::unordered_map<Key, Entry, KeyHash> entries;
+    SDL_Renderer *owner = NULL;
+    unsigned int frame = 0;
+};
@@ -14,8 +14,11 @@ public:
 
     void Draw(SDL_Renderer *renderer, Color color)
     {
-        int *vx = new int[numOfEdges];
-        int *vy = new int[numOfEdges];
+        // scratch from the frame arena, released at the end of the draw call
+        FrameArena &arena = FrameArena::local();
+        FrameArena::Scope scope(arena);
+        int *vx = arena.alloc<int>(numOfEdges);
+        int *vy = arena.alloc<int>(numOfEdges);
 
         for (int i = 0; i < numOfEdges; i++)
         {
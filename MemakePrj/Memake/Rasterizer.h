@@ -0,0 +1,34 @@
+#pragma once
+
+#include <SDL.h>
+
+#include "Colmake.h"
+#include "DrawList.h"
+
+/**
+ * Rasterizer of whole frames into an ARGB8888 buffer, Memake uploads the buffer to a streaming texture
+ * once per frame (see Memake::setRasterizer). The buffer may be written by the user between render() calls.
+ */
+class Rasterizer
+{
+public:
+    virtual ~Rasterizer() {}
+
+    virtual void resize(int width, int height) = 0;
+
+    /**
+     * Buffer for the user to write into, the writes show over what's rendered so far.
+     */
+    virtual Uint32 *getPixels() = 0;
+
+    /**
+     * Buffer to present, read only.
+     */
+    virtual const Uint32 *getPixels() const = 0;
+    virtual int getPitch() const = 0;
+
+    /**
+     * Draw commands of the list over the buffer, with clearColor it's cleared first.
+     */
+    virtual void render(const DrawList &list, const Color *clearColor = NULL) = 0;
+};
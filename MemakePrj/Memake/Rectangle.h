@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Memake.h"
+#include "RenderCalls.h"
 
 class Rectangle
 {
@@ -15,8 +16,8 @@ public:
 
     void Draw(SDL_Renderer *renderer, Color color)
     {
-        SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, 1);
-        SDL_RenderFillRect(renderer, &rect);
+        setRenderDrawColor(renderer, color.r, color.g, color.b, 1);
+        renderFillRect(renderer, &rect);
     }
 
     SDL_Rect rect{};
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <SDL.h>
+#include <cstdlib>
+
+/**
+ * SDL render calls and pixels they fill, issued on the calling thread since the last reset.
+ * Memake reads and resets them once per frame for its FrameStats.
+ */
+struct RenderCounters
+{
+    int calls = 0;
+    Uint64 pixels = 0; // as submitted, before clipping
+
+    /**
+     * Counters of the calling thread.
+     */
+    static RenderCounters &local()
+    {
+        thread_local RenderCounters counters;
+        return counters;
+    }
+
+    void reset()
+    {
+        calls = 0;
+        pixels = 0;
+    }
+};
+
+/*
+ *
+ * COUNTED SDL RENDER CALLS: same arguments and result as the SDL function, Memake draws only through these
+ *
+ */
+inline Uint64 rectPixels(const SDL_Rect &r)
+{
+    return r.w > 0 && r.h > 0 ? (Uint64)r.w * r.h : 0;
+}
+
+inline Uint64 targetPixels(SDL_Renderer *renderer)
+{
+    int w = 0, h = 0;
+    SDL_GetRendererOutputSize(renderer, &w, &h);
+    return (Uint64)w * h;
+}
+
+inline int renderClear(SDL_Renderer *renderer)
+{
+    RenderCounters &c = RenderCounters::local();
+    c.calls++;
+    c.pixels += targetPixels(renderer);
+    return SDL_RenderClear(renderer);
+}
+
+inline int renderFillRect(SDL_Renderer *renderer, const SDL_Rect *rect)
+{
+    RenderCounters &c = RenderCounters::local();
+    c.calls++;
+    c.pixels += rect != NULL ? rectPixels(*rect) : targetPixels(renderer);
+    return SDL_RenderFillRect(renderer, rect);
+}
+
+inline int renderFillRects(SDL_Renderer *renderer, const SDL_Rect *rects, int count)
+{
+    RenderCounters &c = RenderCounters::local();
+    c.calls++;
+    for (int i = 0; i < count; i++)
+    {
+        c.pixels += rectPixels(rects[i]);
+    }
+    return SDL_RenderFillRects(renderer, rects, count);
+}
+
+inline int renderDrawPoint(SDL_Renderer *renderer, int x, int y)
+{
+    RenderCounters &c = RenderCounters::local();
+    c.calls++;
+    c.pixels++;
+    return SDL_RenderDrawPoint(renderer, x, y);
+}
+
+inline int renderDrawPoints(SDL_Renderer *renderer, const SDL_Point *points, int count)
+{
+    RenderCounters &c = RenderCounters::local();
+    c.calls++;
+    c.pixels += count > 0 ? count : 0;
+    return SDL_RenderDrawPoints(renderer, points, count);
+}
+
+inline int renderDrawLine(SDL_Renderer *renderer, int x1, int y1, int x2, int y2)
+{
+    RenderCounters &c = RenderCounters::local();
+    c.calls++;
+    c.pixels += SDL_max(abs(x2 - x1), abs(y2 - y1)) + 1;
+    return SDL_RenderDrawLine(renderer, x1, y1, x2, y2);
+}
+
+inline int renderDrawLines(SDL_Renderer *renderer, const SDL_Point *points, int count)
+{
+    RenderCounters &c = RenderCounters::local();
+    c.calls++;
+    if (count > 0)
+    {
+        // segments share their end points
+        Uint64 pixels = 1;
+        for (int i = 1; i < count; i++)
+        {
+            pixels += SDL_max(abs(points[i].x - points[i - 1].x), abs(points[i].y - points[i - 1].y));
+        }
+        c.pixels += pixels;
+    }
+    return SDL_RenderDrawLines(renderer, points, count);
+}
+
+inline int renderCopy(SDL_Renderer *renderer, SDL_Texture *texture, const SDL_Rect *src, const SDL_Rect *dst)
+{
+    RenderCounters &c = RenderCounters::local();
+    c.calls++;
+    c.pixels += dst != NULL ? rectPixels(*dst) : targetPixels(renderer);
+    return SDL_RenderCopy(renderer, texture, src, dst);
+}
+
+inline int updateTexture(SDL_Texture *texture, const SDL_Rect *rect, const void *pixels, int pitch)
+{
+    RenderCounters::local().calls++;
+    return SDL_UpdateTexture(texture, rect, pixels, pitch);
+}
+
+inline int setRenderDrawColor(SDL_Renderer *renderer, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    RenderCounters::local().calls++;
+    return SDL_SetRenderDrawColor(renderer, r, g, b, a);
+}
+
+inline int setRenderDrawBlendMode(SDL_Renderer *renderer, SDL_BlendMode mode)
+{
+    RenderCounters::local().calls++;
+    return SDL_SetRenderDrawBlendMode(renderer, mode);
+}
+
+inline int setRenderTarget(SDL_Renderer *renderer, SDL_Texture *texture)
+{
+    RenderCounters::local().calls++;
+    return SDL_SetRenderTarget(renderer, texture);
+}
+
+inline int renderSetClipRect(SDL_Renderer *renderer, const SDL_Rect *rect)
+{
+    RenderCounters::local().calls++;
+    return SDL_RenderSetClipRect(renderer, rect);
+}
+
+inline int setTextureColorMod(SDL_Texture *texture, Uint8 r, Uint8 g, Uint8 b)
+{
+    RenderCounters::local().calls++;
+    return SDL_SetTextureColorMod(texture, r, g, b);
+}
+
+inline int setTextureAlphaMod(SDL_Texture *texture, Uint8 alpha)
+{
+    RenderCounters::local().calls++;
+    return SDL_SetTextureAlphaMod(texture, alpha);
+}
+
+inline int setTextureBlendMode(SDL_Texture *texture, SDL_BlendMode mode)
+{
+    RenderCounters::local().calls++;
+    return SDL_SetTextureBlendMode(texture, mode);
+}
+
+inline void renderPresent(SDL_Renderer *renderer)
+{
+    RenderCounters::local().calls++;
+    SDL_RenderPresent(renderer);
+}
@@ -0,0 +1,307 @@
+#include "Scene.h"
+#include <algorithm>
+
+static long long rectArea(const SDL_Rect &r)
+{
+    return (long long)r.w * r.h;
+}
+
+static SDL_Rect rectUnion(const SDL_Rect &a, const SDL_Rect &b)
+{
+    SDL_Rect u;
+    SDL_UnionRect(&a, &b, &u);
+    return u;
+}
+
+// overlapping or touching rects, merging them adds no area that wasn't adjacent
+static bool rectsTouch(const SDL_Rect &a, const SDL_Rect &b)
+{
+    return a.x <= b.x + b.w && b.x <= a.x + a.w && a.y <= b.y + b.h && b.y <= a.y + a.h;
+}
+
+void DirtyRegion::insert(SDL_Rect r)
+{
+    // merged rect can touch others it didn't before, so merge until nothing touches
+    for (size_t i = 0; i < rects.size();)
+    {
+        if (rectsTouch(rects[i], r))
+        {
+            r = rectUnion(rects[i], r);
+            rects[i] = rects.back();
+            rects.pop_back();
+            i = 0;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+    rects.push_back(r);
+}
+
+void DirtyRegion::add(SDL_Rect r)
+{
+    const SDL_Rect screen = {0, 0, w, h};
+    if (!SDL_IntersectRect(&r, &screen, &r))
+    {
+        return;
+    }
+    insert(r);
+
+    while ((int)rects.size() > maxRects)
+    {
+        size_t bestA = 0, bestB = 1;
+        long long bestGrowth = -1;
+        for (size_t a = 0; a < rects.size(); ++a)
+        {
+            for (size_t b = a + 1; b < rects.size(); ++b)
+            {
+                const long long growth = rectArea(rectUnion(rects[a], rects[b])) - rectArea(rects[a]) - rectArea(rects[b]);
+                if (bestGrowth < 0 || growth < bestGrowth)
+                {
+                    bestGrowth = growth;
+                    bestA = a;
+                    bestB = b;
+                }
+            }
+        }
+        const SDL_Rect merged = rectUnion(rects[bestA], rects[bestB]);
+        rects.erase(rects.begin() + bestB);
+        rects.erase(rects.begin() + bestA);
+        insert(merged);
+    }
+
+    // past half the screen one full redraw is cheaper than many clipped passes
+    long long area = 0;
+    for (const SDL_Rect &d : rects)
+    {
+        area += rectArea(d);
+    }
+    if (area * 2 > rectArea(screen))
+    {
+        addAll();
+    }
+}
+
+void DirtyRegion::addAll()
+{
+    rects.assign(1, {0, 0, w, h});
+}
+
+SDL_Rect Scene::computeBounds(const Shape &shape)
+{
+    const DrawCmd &c = shape.cmd;
+    switch (c.type)
+    {
+    case DrawCmdType::Rect:
+        return {c.x1, c.y1, c.x2, c.y2};
+    case DrawCmdType::Ellipse:
+    case DrawCmdType::EllipseBorder:
+        return {c.x1 - c.x2, c.y1 - c.y2, 2 * c.x2 + 1, 2 * c.y2 + 1};
+    case DrawCmdType::Line:
+    case DrawCmdType::AALine:
+    {
+        // anti-aliased lines blend into the neighbour pixel
+        const int pad = c.type == DrawCmdType::AALine ? 1 : 0;
+        const int x = SDL_min(c.x1, c.x2) - pad;
+        const int y = SDL_min(c.y1, c.y2) - pad;
+        return {x, y, SDL_max(c.x1, c.x2) + pad - x + 1, SDL_max(c.y1, c.y2) + pad - y + 1};
+    }
+    case DrawCmdType::Polygon:
+    {
+        if (shape.vx.empty())
+        {
+            return {0, 0, 0, 0};
+        }
+        const auto xs = std::minmax_element(shape.vx.begin(), shape.vx.end());
+        const auto ys = std::minmax_element(shape.vy.begin(), shape.vy.end());
+        return {*xs.first, *ys.first, *xs.second - *xs.first + 1, *ys.second - *ys.first + 1};
+    }
+    default:
+        return {c.x1, c.y1, 1, 1};
+    }
+}
+
+int Scene::add(Shape &&shape)
+{
+    shape.bounds = computeBounds(shape);
+    dirty.add(shape.bounds);
+    const int id = nextId++;
+    shapes.emplace(id, std::move(shape));
+    return id;
+}
+
+int Scene::add(const DrawCmd &cmd)
+{
+    Shape shape;
+    shape.cmd = cmd;
+    return add(std::move(shape));
+}
+
+int Scene::addRect(int x, int y, int width, int height, Color color)
+{
+    return add(DrawCmd{DrawCmdType::Rect, color, x, y, width, height, 0, 0});
+}
+
+int Scene::addEllipse(int x, int y, int rx, int ry, Color color)
+{
+    return add(DrawCmd{DrawCmdType::Ellipse, color, x, y, rx, ry, 0, 0});
+}
+
+int Scene::addEllipseBorder(int x, int y, int rx, int ry, Color color)
+{
+    return add(DrawCmd{DrawCmdType::EllipseBorder, color, x, y, rx, ry, 0, 0});
+}
+
+int Scene::addLine(int x1, int y1, int x2, int y2, Color color, bool antialias)
+{
+    return add(DrawCmd{antialias ? DrawCmdType::AALine : DrawCmdType::Line, color, x1, y1, x2, y2, 0, 0});
+}
+
+int Scene::addDot(int x, int y, Color color)
+{
+    return add(DrawCmd{DrawCmdType::Dot, color, x, y, 0, 0, 0, 0});
+}
+
+int Scene::addPolygon(const Vector2 *edgesPos, int numOfEdges, Color color)
+{
+    Shape shape;
+    shape.cmd = {DrawCmdType::Polygon, color, 0, 0, 0, 0, 0, 0};
+    for (int i = 0; i < numOfEdges; i++)
+    {
+        shape.vx.push_back(edgesPos[i].x);
+        shape.vy.push_back(edgesPos[i].y);
+    }
+    return add(std::move(shape));
+}
+
+void Scene::moveBy(int id, int dx, int dy)
+{
+    auto it = shapes.find(id);
+    if (it == shapes.end() || (dx == 0 && dy == 0))
+    {
+        return;
+    }
+    Shape &shape = it->second;
+    DrawCmd &c = shape.cmd;
+    if (c.type == DrawCmdType::Polygon)
+    {
+        for (size_t i = 0; i < shape.vx.size(); ++i)
+        {
+            shape.vx[i] += dx;
+            shape.vy[i] += dy;
+        }
+    }
+    else
+    {
+        c.x1 += dx;
+        c.y1 += dy;
+        if (c.type == DrawCmdType::Line || c.type == DrawCmdType::AALine)
+        {
+            c.x2 += dx;
+            c.y2 += dy;
+        }
+    }
+
+    dirty.add(shape.bounds);
+    shape.bounds = computeBounds(shape);
+    dirty.add(shape.bounds);
+}
+
+void Scene::moveTo(int id, int x, int y)
+{
+    auto it = shapes.find(id);
+    if (it == shapes.end())
+    {
+        return;
+    }
+    const Shape &shape = it->second;
+    if (shape.cmd.type == DrawCmdType::Polygon)
+    {
+        if (!shape.vx.empty())
+        {
+            moveBy(id, x - shape.vx[0], y - shape.vy[0]);
+        }
+        return;
+    }
+    moveBy(id, x - shape.cmd.x1, y - shape.cmd.y1);
+}
+
+void Scene::setColor(int id, Color color)
+{
+    auto it = shapes.find(id);
+    if (it == shapes.end())
+    {
+        return;
+    }
+    Color &c = it->second.cmd.color;
+    if (c.r != color.r || c.g != color.g || c.b != color.b || c.a != color.a)
+    {
+        c = color;
+        dirty.add(it->second.bounds);
+    }
+}
+
+void Scene::remove(int id)
+{
+    auto it = shapes.find(id);
+    if (it != shapes.end())
+    {
+        dirty.add(it->second.bounds);
+        shapes.erase(it);
+    }
+}
+
+void Scene::clear()
+{
+    shapes.clear();
+    dirty.addAll();
+}
+
+bool Scene::getBounds(int id, SDL_Rect &bounds) const
+{
+    auto it = shapes.find(id);
+    if (it == shapes.end())
+    {
+        return false;
+    }
+    bounds = it->second.bounds;
+    return true;
+}
+
+void Scene::record(DrawList &list, const SDL_Rect &area) const
+{
+    for (const auto &it : shapes)
+    {
+        const Shape &shape = it.second;
+        if (!SDL_HasIntersection(&shape.bounds, &area))
+        {
+            continue;
+        }
+        const DrawCmd &c = shape.cmd;
+        switch (c.type)
+        {
+        case DrawCmdType::Rect:
+            list.addRect(c.x1, c.y1, c.x2, c.y2, c.color);
+            break;
+        case DrawCmdType::Ellipse:
+            list.addEllipse(c.x1, c.y1, c.x2, c.y2, c.color);
+            break;
+        case DrawCmdType::EllipseBorder:
+            list.addEllipseBorder(c.x1, c.y1, c.x2, c.y2, c.color);
+            break;
+        case DrawCmdType::Line:
+            list.addLine(c.x1, c.y1, c.x2, c.y2, c.color);
+            break;
+        case DrawCmdType::AALine:
+            list.addAALine(c.x1, c.y1, c.x2, c.y2, c.color);
+            break;
+        case DrawCmdType::Polygon:
+            list.addPolygon(shape.vx.data(), shape.vy.data(), (int)shape.vx.size(), c.color);
+            break;
+        default:
+            list.addDot(c.x1, c.y1, c.color);
+            break;
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <SDL.h>
+
+#include "Colmake.h"
+#include "Vector2d.h"
+#include "DrawList.h"
+
+/**
+ * Damaged screen area as a few rects. Added rects are merged with ones they overlap or touch,
+ * past maxRects the pair growing least is merged, and a region covering most of the screen becomes the whole screen.
+ */
+class DirtyRegion
+{
+public:
+    explicit DirtyRegion(int maxRects = 16) : maxRects(maxRects) {}
+
+    void setBounds(int width, int height) { w = width; h = height; }
+    void add(SDL_Rect r);
+    void addAll();
+    void clear() { rects.clear(); }
+    bool empty() const { return rects.empty(); }
+    const std::vector<SDL_Rect> &getRects() const { return rects; }
+
+private:
+    void insert(SDL_Rect r);
+
+    int maxRects;
+    int w = 0;
+    int h = 0;
+    std::vector<SDL_Rect> rects;
+};
+
+/**
+ * Retained shapes for dirty rectangle drawing.
+ * Shapes are added once and get a handle, moving, recoloring or removing one damages its old and new bounds.
+ * Memake then clears and redraws only the damaged area (see Memake::setScene), shapes are drawn in order of adding.
+ */
+class Scene
+{
+public:
+    int addRect(int x, int y, int width, int height, Color color);
+    int addEllipse(int x, int y, int rx, int ry, Color color);
+    int addEllipseBorder(int x, int y, int rx, int ry, Color color);
+    int addLine(int x1, int y1, int x2, int y2, Color color, bool antialias = false);
+    int addDot(int x, int y, Color color);
+    int addPolygon(const Vector2 *edgesPos, int numOfEdges, Color color);
+
+    /**
+     * Move shape by (dx, dy), all its points move.
+     */
+    void moveBy(int id, int dx, int dy);
+
+    /**
+     * Move shape so its position (top left of rect, center of ellipse, first point otherwise) is (x, y).
+     */
+    void moveTo(int id, int x, int y);
+
+    void setColor(int id, Color color);
+    void remove(int id);
+    void clear();
+
+    /**
+     * Damage the whole screen, e.g. after the background color changed.
+     */
+    void invalidate() { dirty.addAll(); }
+
+    bool getBounds(int id, SDL_Rect &bounds) const;
+    size_t size() const { return shapes.size(); }
+
+    DirtyRegion &getDirty() { return dirty; }
+
+    /**
+     * Add commands of shapes overlapping area to the list.
+     */
+    void record(DrawList &list, const SDL_Rect &area) const;
+
+private:
+    struct Shape
+    {
+        DrawCmd cmd;
+        SDL_Rect bounds;
+        std::vector<int> vx, vy; // polygon vertices
+    };
+
+    int add(Shape &&shape);
+    int add(const DrawCmd &cmd);
+    static SDL_Rect computeBounds(const Shape &shape);
+
+    std::map<int, Shape> shapes; // ordered by id, which is the draw order
+    int nextId = 0;
+    DirtyRegion dirty;
+};
@@ -0,0 +1,315 @@
+#include "SoftRaster.h"
+#include "Layer.h"
+#include "Polkadot.h"
+#include <algorithm>
+#include <cstring>
+
+static const int k_chunkCmds = 64;
+
+// SDL_IntersectRect without the call, it runs for every fragment in every tile
+static inline bool clipRect(const SDL_Rect &a, const SDL_Rect &b, SDL_Rect &r)
+{
+    const int x0 = SDL_max(a.x, b.x);
+    const int y0 = SDL_max(a.y, b.y);
+    const int x1 = SDL_min(a.x + a.w, b.x + b.w);
+    const int y1 = SDL_min(a.y + a.h, b.y + b.h);
+    r = {x0, y0, x1 - x0, y1 - y0};
+    return x1 > x0 && y1 > y0;
+}
+
+void SoftRaster::resize(int width, int height)
+{
+    w = SDL_max(width, 0);
+    h = SDL_max(height, 0);
+    pixels.assign((size_t)w * h, 0xFF000000);
+    tilesX = (w + k_tileSize - 1) / k_tileSize;
+    tilesY = (h + k_tileSize - 1) / k_tileSize;
+    bins.resize(tilesX * tilesY);
+}
+
+void SoftRaster::gather(const DrawList &list)
+{
+    const std::vector<DrawCmd> &cmds = list.getCmds();
+    for (const DrawCmd &cmd : cmds)
+    {
+        if (cmd.type == DrawCmdType::Layer)
+        {
+            // layer content is drawn where the layer is
+            gather(*list.getLayers()[cmd.x1].list);
+            continue;
+        }
+
+        // tree caches aren't thread safe, look trees up before the parallel part
+        const AALineBatch *tree = NULL;
+        if (cmd.type == DrawCmdType::FractalTree)
+        {
+            const FractalTreeParams params = {cmd.x1, cmd.y1, cmd.x2, cmd.y2, cmd.x3, cmd.y3};
+            if (treeCache != NULL)
+            {
+                tree = &treeCache->getPoints(params);
+            }
+            else
+            {
+                ownTrees.emplace_back(new AALineBatch());
+                RenderTreeLines(*ownTrees.back(), cmd.x1, cmd.y1, cmd.x2, cmd.y2, cmd.x3, cmd.y3);
+                tree = ownTrees.back().get();
+            }
+        }
+        src.push_back({&cmd, &list});
+        trees.push_back(tree);
+    }
+}
+
+void SoftRaster::render(const DrawList &list, const Color *clearColor)
+{
+    if (w == 0 || h == 0)
+    {
+        return;
+    }
+
+    src.clear();
+    trees.clear();
+    ownTrees.clear();
+    gather(list);
+
+    const int cmdCnt = (int)src.size();
+    const int chunkCnt = (cmdCnt + k_chunkCmds - 1) / k_chunkCmds;
+    cmdFrags.resize(cmdCnt);
+    if ((int)chunks.size() < chunkCnt)
+    {
+        chunks.resize(chunkCnt);
+    }
+
+    // commands to fragments
+    if (pool != NULL)
+    {
+        pool->parallelFor(chunkCnt, [this](int chunk) { buildChunk(chunk); });
+    }
+    else
+    {
+        for (int i = 0; i < chunkCnt; ++i)
+        {
+            buildChunk(i);
+        }
+    }
+
+    // bin by bounds, in submission order
+    for (std::vector<int> &bin : bins)
+    {
+        bin.clear();
+    }
+    for (int i = 0; i < cmdCnt; ++i)
+    {
+        const SDL_Rect &b = cmdFrags[i].bounds;
+        if (b.w <= 0 || b.h <= 0)
+        {
+            continue;
+        }
+        const int tx0 = SDL_max(b.x, 0) / k_tileSize;
+        const int ty0 = SDL_max(b.y, 0) / k_tileSize;
+        const int tx1 = SDL_min(b.x + b.w - 1, w - 1) / k_tileSize;
+        const int ty1 = SDL_min(b.y + b.h - 1, h - 1) / k_tileSize;
+        for (int ty = ty0; ty <= ty1; ++ty)
+        {
+            for (int tx = tx0; tx <= tx1; ++tx)
+            {
+                bins[ty * tilesX + tx].push_back(i);
+            }
+        }
+    }
+
+    if (pool != NULL)
+    {
+        pool->parallelFor(tilesX * tilesY, [this, clearColor](int tile) { renderTile(tile, clearColor); });
+    }
+    else
+    {
+        for (int i = 0; i < tilesX * tilesY; ++i)
+        {
+            renderTile(i, clearColor);
+        }
+    }
+}
+
+void SoftRaster::buildChunk(int chunk)
+{
+    Chunk &c = chunks[chunk];
+    c.rects.clear();
+    c.alphas.clear();
+    c.images.clear();
+
+    const SDL_Rect screen = {0, 0, w, h};
+    const int beg = chunk * k_chunkCmds;
+    const int end = SDL_min(beg + k_chunkCmds, (int)src.size());
+    for (int i = beg; i < end; ++i)
+    {
+        CmdFragments &cf = cmdFrags[i];
+        cf.chunk = chunk;
+        cf.color = packARGB(src[i].cmd->color);
+        cf.alphas = -1;
+        cf.image = -1;
+        cf.beg = (int)c.rects.size();
+        buildCmd(i, screen, c, cf);
+        cf.end = (int)c.rects.size();
+
+        // screen clipped bounds, empty when nothing is visible
+        int x0 = w, y0 = h, x1 = 0, y1 = 0;
+        for (int k = cf.beg; k < cf.end; ++k)
+        {
+            SDL_Rect r;
+            if (clipRect(c.rects[k], screen, r))
+            {
+                x0 = SDL_min(x0, r.x);
+                y0 = SDL_min(y0, r.y);
+                x1 = SDL_max(x1, r.x + r.w);
+                y1 = SDL_max(y1, r.y + r.h);
+            }
+        }
+        cf.bounds = {x0, y0, x1 - x0, y1 - y0};
+    }
+}
+
+void SoftRaster::buildCmd(int idx, const SDL_Rect &screen, Chunk &c, CmdFragments &cf)
+{
+    // off screen commands leave no fragments, spans are cut to the screen as they're made
+    const DrawCmd &cmd = *src[idx].cmd;
+    if (!DrawList::isVisible(cmd, screen))
+    {
+        return;
+    }
+    switch (cmd.type)
+    {
+    case DrawCmdType::Rect:
+        c.rects.push_back({cmd.x1, cmd.y1, cmd.x2, cmd.y2});
+        break;
+    case DrawCmdType::Dot:
+        c.rects.push_back({cmd.x1, cmd.y1, 1, 1});
+        break;
+    case DrawCmdType::Line:
+        lineRuns(cmd.x1, cmd.y1, cmd.x2, cmd.y2, true, c.rects);
+        break;
+    case DrawCmdType::Ellipse:
+        filledEllipseSpans(cmd.x1, cmd.y1, cmd.x2, cmd.y2, c.rects, &screen);
+        break;
+    case DrawCmdType::Polygon:
+        filledPolygonSpans(src[idx].list->getVx() + cmd.x1, src[idx].list->getVy() + cmd.x1, cmd.x2, c.rects,
+                           &screen);
+        break;
+    case DrawCmdType::EllipseBorder:
+        // closed polyline, every segment without its end so no pixel is drawn twice
+        c.points.clear();
+        borderEllipsePoints(cmd.x1, cmd.y1, cmd.x2, cmd.y2, c.points);
+        for (size_t i = 0; i + 1 < c.points.size(); ++i)
+        {
+            lineRuns(c.points[i].x, c.points[i].y, c.points[i + 1].x, c.points[i + 1].y, false, c.rects);
+        }
+        break;
+    case DrawCmdType::AALine:
+    case DrawCmdType::FractalTree:
+    {
+        const AALineBatch *batch = trees[idx];
+        thread_local AALineBatch line;
+        if (cmd.type == DrawCmdType::AALine)
+        {
+            line.clear();
+            line.addLine(cmd.x1, cmd.y1, cmd.x2, cmd.y2);
+            batch = &line;
+        }
+        cf.alphas = (int)c.alphas.size();
+        batch->forEachPoint([&](const SDL_Point &p, int level) {
+            c.rects.push_back({p.x, p.y, 1, 1});
+            c.alphas.push_back(AALineBatch::levelAlpha(level, cmd.color.a));
+        });
+        break;
+    }
+    case DrawCmdType::Polkadot:
+    {
+        const Polkadot polkadot(SDL_max(cmd.x1, 0), SDL_max(cmd.y1, 0), SDL_min(cmd.x2, w), SDL_min(cmd.y2, h));
+        const int pw = polkadot.GetWidth();
+        const int ph = polkadot.GetHeight();
+        if (pw > 0 && ph > 0)
+        {
+            cf.image = (int)c.images.size();
+            c.images.resize(c.images.size() + (size_t)pw * ph);
+            polkadot.Fill(&c.images[cf.image], pw * sizeof(Uint32));
+            c.rects.push_back({polkadot.x1, polkadot.y1, pw, ph});
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void SoftRaster::renderTile(int tile, const Color *clearColor)
+{
+    const int tx = tile % tilesX;
+    const int ty = tile / tilesX;
+    const SDL_Rect area = {tx * k_tileSize, ty * k_tileSize, SDL_min(k_tileSize, w - tx * k_tileSize),
+                           SDL_min(k_tileSize, h - ty * k_tileSize)};
+
+    // framebuffer rows are a pitch apart and fight for the same cache sets, draw into a packed tile instead
+    alignas(16) Uint32 buf[k_tileSize * k_tileSize];
+    Uint32 *const origin = pixels.data() + (size_t)area.y * w + area.x;
+    if (clearColor != NULL)
+    {
+        const Uint32 bg = packARGB({clearColor->r, clearColor->g, clearColor->b, 0xFF});
+        fillSpan32(buf, k_tileSize * area.h, bg);
+    }
+    else
+    {
+        for (int y = 0; y < area.h; ++y)
+        {
+            memcpy(buf + y * k_tileSize, origin + (size_t)y * w, area.w * sizeof(Uint32));
+        }
+    }
+
+    for (int id : bins[tile])
+    {
+        const CmdFragments &cf = cmdFrags[id];
+        const Chunk &c = chunks[cf.chunk];
+        const bool opaque = (cf.color >> 24) == 0xFF;
+        for (int k = cf.beg; k < cf.end; ++k)
+        {
+            SDL_Rect r;
+            if (!clipRect(c.rects[k], area, r))
+            {
+                continue;
+            }
+            Uint32 *row = buf + (r.y - area.y) * k_tileSize + (r.x - area.x);
+            if (cf.image >= 0)
+            {
+                const SDL_Rect &f = c.rects[k];
+                const Uint32 *img = &c.images[cf.image + (size_t)(r.y - f.y) * f.w + (r.x - f.x)];
+                for (int y = 0; y < r.h; ++y, row += k_tileSize, img += f.w)
+                {
+                    memcpy(row, img, r.w * sizeof(Uint32));
+                }
+            }
+            else if (cf.alphas >= 0)
+            {
+                // anti-aliased points are single pixels
+                blendSpan32(row, 1, (cf.color & 0x00FFFFFF) | ((Uint32)c.alphas[cf.alphas + k - cf.beg] << 24));
+            }
+            else if (opaque)
+            {
+                for (int y = 0; y < r.h; ++y, row += k_tileSize)
+                {
+                    fillSpan32(row, r.w, cf.color);
+                }
+            }
+            else
+            {
+                for (int y = 0; y < r.h; ++y, row += k_tileSize)
+                {
+                    blendSpan32(row, r.w, cf.color);
+                }
+            }
+        }
+    }
+
+    for (int y = 0; y < area.h; ++y)
+    {
+        memcpy(origin + (size_t)y * w, buf + y * k_tileSize, area.w * sizeof(Uint32));
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <SDL.h>
+
+#include "Colmake.h"
+#include "DrawList.h"
+#include "SpanFill.h"
+#include "WorkerPool.h"
+#include "Rasterizer.h"
+
+/**
+ * CPU rasterizer of draw lists into an ARGB8888 framebuffer.
+ * Commands are turned into pixel rects (spans, runs of line pixels, anti-aliased points) in parallel chunks,
+ * binned into k_tileSize square screen tiles by bounds, and every tile is filled by one worker in submission order,
+ * so no two threads write the same pixel and the result doesn't depend on the thread count.
+ * Layers are drawn from their recorded commands, circle sprites aren't used (circles are filled as spans).
+ */
+class SoftRaster : public Rasterizer
+{
+public:
+    static const int k_tileSize = 64;
+
+    explicit SoftRaster(WorkerPool *pool = NULL) : pool(pool) {}
+
+    void setWorkerPool(WorkerPool *pool) { this->pool = pool; }
+
+    /**
+     * Trees are taken from the cache like DrawList does, NULL to generate them every frame.
+     */
+    void setFractalTreeCache(FractalTreeCache *cache) { treeCache = cache; }
+
+    void resize(int width, int height) override;
+    Uint32 *getPixels() override { return pixels.data(); }
+    const Uint32 *getPixels() const override { return pixels.data(); }
+    int getPitch() const override { return w * (int)sizeof(Uint32); }
+    void render(const DrawList &list, const Color *clearColor = NULL) override;
+
+private:
+    struct SrcCmd
+    {
+        const DrawCmd *cmd;
+        const DrawList *list;
+    };
+
+    // pixel rects of a command: filled with its color, blended per rect by alphas for anti-aliased points,
+    // or copied from chunk images for polkadots
+    struct CmdFragments
+    {
+        int chunk;
+        int beg, end;
+        Uint32 color;
+        int alphas;
+        int image;
+        SDL_Rect bounds;
+    };
+
+    // fragments of a run of commands, built by one worker
+    struct Chunk
+    {
+        std::vector<SDL_Rect> rects;
+        std::vector<Uint8> alphas;
+        std::vector<Uint32> images;
+        std::vector<SDL_Point> points;
+    };
+
+    void gather(const DrawList &list);
+    void buildChunk(int chunk);
+    void buildCmd(int idx, const SDL_Rect &screen, Chunk &c, CmdFragments &cf);
+    void renderTile(int tile, const Color *clearColor);
+
+    WorkerPool *pool;
+    FractalTreeCache *treeCache = NULL;
+    int w = 0;
+    int h = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+    std::vector<Uint32> pixels;
+
+    // kept between frames to avoid allocations
+    std::vector<SrcCmd> src;
+    std::vector<const AALineBatch *> trees; // per command, fractal tree points
+    std::vector<std::unique_ptr<AALineBatch>> ownTrees;
+    std::vector<CmdFragments> cmdFrags;
+    std::vector<Chunk> chunks;
+    std::vector<std::vector<int>> bins; // command ids per tile
+};
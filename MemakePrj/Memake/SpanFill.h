@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <SDL.h>
+#include "Colmake.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MEMAKE_SSE2
+#endif
+
+/*
+ *
+ * SOFTWARE RASTER UTILS: 32-bit pixel span writes
+ *
+ */
+inline Uint32 packARGB(Color color)
+{
+    return ((Uint32)color.a << 24) | ((Uint32)color.r << 16) | ((Uint32)color.g << 8) | (Uint32)color.b;
+}
+
+inline void fillSpan32(Uint32 *dst, int cnt, Uint32 color)
+{
+#ifdef MEMAKE_SSE2
+    // head until 16 byte aligned, then 4 pixels per store
+    while (cnt > 0 && ((uintptr_t)dst & 15))
+    {
+        *dst++ = color;
+        --cnt;
+    }
+    const __m128i c = _mm_set1_epi32((int)color);
+    for (; cnt >= 8; cnt -= 8, dst += 8)
+    {
+        _mm_store_si128((__m128i *)dst, c);
+        _mm_store_si128((__m128i *)(dst + 4), c);
+    }
+    for (; cnt >= 4; cnt -= 4, dst += 4)
+    {
+        _mm_store_si128((__m128i *)dst, c);
+    }
+#endif
+    while (cnt-- > 0)
+    {
+        *dst++ = color;
+    }
+}
+
+// Blend color over cnt pixels like SDL_BLENDMODE_BLEND: dst = src * a + dst * (1 - a), dstA = a + dstA * (1 - a).
+// x / 255 is computed exactly as (x + 1 + (x >> 8)) >> 8 for x up to 255 * 255, so SSE2 and scalar agree.
+inline void blendSpan32(Uint32 *dst, int cnt, Uint32 color)
+{
+    const Uint32 a = color >> 24;
+    if (a == 0)
+    {
+        return;
+    }
+    const Uint32 ia = 255 - a;
+    const Uint32 sr = (color >> 16 & 0xFF) * a;
+    const Uint32 sg = (color >> 8 & 0xFF) * a;
+    const Uint32 sb = (color & 0xFF) * a;
+    const Uint32 sa = 255 * a;
+#ifdef MEMAKE_SSE2
+    // 2 pixels per 16-bit lanes half, premultiplied source is the same for all of them
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i src = _mm_setr_epi16((short)sb, (short)sg, (short)sr, (short)sa, (short)sb, (short)sg, (short)sr, (short)sa);
+    const __m128i inv = _mm_set1_epi16((short)ia);
+    const __m128i one = _mm_set1_epi16(1);
+    for (; cnt >= 4; cnt -= 4, dst += 4)
+    {
+        const __m128i d = _mm_loadu_si128((const __m128i *)dst);
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv), src);
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv), src);
+        lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, one), _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, one), _mm_srli_epi16(hi, 8)), 8);
+        _mm_storeu_si128((__m128i *)dst, _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; cnt > 0; --cnt, ++dst)
+    {
+        const Uint32 d = *dst;
+        Uint32 r = (d >> 16 & 0xFF) * ia + sr;
+        Uint32 g = (d >> 8 & 0xFF) * ia + sg;
+        Uint32 b = (d & 0xFF) * ia + sb;
+        Uint32 al = (d >> 24) * ia + sa;
+        r = (r + 1 + (r >> 8)) >> 8;
+        g = (g + 1 + (g >> 8)) >> 8;
+        b = (b + 1 + (b >> 8)) >> 8;
+        al = (al + 1 + (al >> 8)) >> 8;
+        *dst = (al << 24) | (r << 16) | (g << 8) | b;
+    }
+}
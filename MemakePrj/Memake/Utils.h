@@ -2,8 +2,14 @@
 #include <cmath>
 #include <cstdlib>
 #include <utility>
+#include <algorithm>
+#include <vector>
+#include <unordered_map>
 #include <SDL.h>
 
+#include "FrameArena.h"
+#include "RenderCalls.h"
+
 /*
  *
  * COMMON UTILS
@@ -30,16 +36,18 @@ double inline rfPart(double x) { return 1 - fPart(x); }
 
 /*
  *
- * FRACTAL TREE UTILS
+ * ANTI-ALIASED LINE AND FRACTAL TREE UTILS
  *
  */
 inline void plot(SDL_Renderer *renderer, int x, int y, double brightness, SDL_Color color)
 {
-    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, brightness * 0xFF);
-    SDL_RenderDrawPoint(renderer, x, y);
+    setRenderDrawColor(renderer, color.r, color.g, color.b, brightness * 0xFF);
+    renderDrawPoint(renderer, x, y);
 }
 
-inline void wuLine(SDL_Renderer *renderer, double x0, double y0, double x1, double y1, SDL_Color color)
+/* Xiaolin Wu line, plot(x, y, brightness) is called for every covered pixel */
+template<typename Plot>
+inline void wuLineCoverage(double x0, double y0, double x1, double y1, Plot plot)
 {
     bool steep = fabs(y1 - y0) > fabs(x1 - x0);
 
@@ -68,14 +76,14 @@ inline void wuLine(SDL_Renderer *renderer, double x0, double y0, double x1, doub
 
     if (steep)
     {
-        plot(renderer, yPixel1, xPixel1, rfPart(yEnd) * xGap, color);
-        plot(renderer, yPixel1 + 1, xPixel1, fPart(yEnd) * xGap, color);
+        plot(yPixel1, xPixel1, rfPart(yEnd) * xGap);
+        plot(yPixel1 + 1, xPixel1, fPart(yEnd) * xGap);
     }
 
     else
     {
-        plot(renderer, xPixel1, yPixel1, rfPart(yEnd) * xGap, color);
-        plot(renderer, xPixel1, yPixel1 + 1, fPart(yEnd) * xGap, color);
+        plot(xPixel1, yPixel1, rfPart(yEnd) * xGap);
+        plot(xPixel1, yPixel1 + 1, fPart(yEnd) * xGap);
     }
 
     double yIntersection = yEnd + gradient;
@@ -88,57 +96,157 @@ inline void wuLine(SDL_Renderer *renderer, double x0, double y0, double x1, doub
 
     if (steep)
     {
-        plot(renderer, yPixel2, xPixel2, rfPart(yEnd) * xGap, color);
-        plot(renderer, yPixel2 + 1, xPixel2, fPart(yEnd) * xGap, color);
+        plot(yPixel2, xPixel2, rfPart(yEnd) * xGap);
+        plot(yPixel2 + 1, xPixel2, fPart(yEnd) * xGap);
 
         for (int x = xPixel1 + 1; x <= (xPixel2 - 1); x++)
         {
-            plot(renderer, yIntersection, x, rfPart(yIntersection), color);
-            plot(renderer, yIntersection + 1, x, fPart(yIntersection), color);
+            plot(yIntersection, x, rfPart(yIntersection));
+            plot(yIntersection + 1, x, fPart(yIntersection));
             yIntersection += gradient;
         }
     }
 
     else
     {
-        plot(renderer, xPixel2, yPixel2, rfPart(yEnd) * xGap, color);
-        plot(renderer, xPixel2, yPixel2 + 1, fPart(yEnd) * xGap, color);
+        plot(xPixel2, yPixel2, rfPart(yEnd) * xGap);
+        plot(xPixel2, yPixel2 + 1, fPart(yEnd) * xGap);
 
         for (int x = xPixel1 + 1; x <= (xPixel2 - 1); x++)
         {
-            plot(renderer, x, yIntersection, rfPart(yIntersection), color);
-            plot(renderer, x, yIntersection + 1, fPart(yIntersection), color);
+            plot(x, yIntersection, rfPart(yIntersection));
+            plot(x, yIntersection + 1, fPart(yIntersection));
             yIntersection += gradient;
         }
     }
 }
 
-inline void RenderTree(SDL_Renderer *renderer, int startX, int startY, int lineLength, int lineLengthSeed, int angle, int angleSeed, SDL_Color color = {255, 255, 255, 255})
+inline void wuLine(SDL_Renderer *renderer, double x0, double y0, double x1, double y1, SDL_Color color)
 {
-    // Uncomment for slow animation
-    //SDL_RenderPresent(renderer);
+    wuLineCoverage(x0, y0, x1, y1, [&](int x, int y, double brightness) { plot(renderer, x, y, brightness, color); });
+}
+
+/* Anti-aliased lines gathered as points grouped by quantized coverage.
+   flush() blends them with one SDL_RenderDrawPoints per alpha level instead of two renderer calls per pixel. */
+class AALineBatch
+{
+public:
+    static const int k_alphaLevels = 32;
+
+    bool empty() const { return pointCnt == 0; }
+
+    void clear()
+    {
+        for (int i = 1; i < k_alphaLevels; i++)
+        {
+            levels[i].clear();
+        }
+        pointCnt = 0;
+    }
+
+    void addLine(double x0, double y0, double x1, double y1)
+    {
+        wuLineCoverage(x0, y0, x1, y1, [this](int x, int y, double brightness) {
+            const int level = (int)(brightness * (k_alphaLevels - 1) + 0.5);
+            if (level > 0)
+            {
+                levels[level].push_back({x, y});
+                ++pointCnt;
+            }
+        });
+    }
 
+    /* Add every point of another batch, e.g. cached geometry */
+    void append(const AALineBatch &other)
+    {
+        for (int i = 1; i < k_alphaLevels; i++)
+        {
+            levels[i].insert(levels[i].end(), other.levels[i].begin(), other.levels[i].end());
+        }
+        pointCnt += other.pointCnt;
+    }
+
+    /* f(point, level) for every point */
+    template<typename Func>
+    void forEachPoint(Func f) const
+    {
+        for (int i = 1; i < k_alphaLevels; i++)
+        {
+            for (const SDL_Point &p : levels[i])
+            {
+                f(p, i);
+            }
+        }
+    }
+
+    static Uint8 levelAlpha(int level, Uint8 alpha)
+    {
+        return (Uint8)(alpha * level / (k_alphaLevels - 1));
+    }
+
+    int flush(SDL_Renderer *renderer, SDL_Color color)
+    {
+        int result = 0;
+        if (pointCnt == 0)
+        {
+            return result;
+        }
+
+        result |= setRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+        for (int i = 1; i < k_alphaLevels; i++)
+        {
+            if (!levels[i].empty())
+            {
+                result |= setRenderDrawColor(renderer, color.r, color.g, color.b, levelAlpha(i, color.a));
+                result |= renderDrawPoints(renderer, levels[i].data(), (int)levels[i].size());
+                levels[i].clear();
+            }
+        }
+        pointCnt = 0;
+        return result;
+    }
+
+private:
+    std::vector<SDL_Point> levels[k_alphaLevels]; // level 0 is never drawn
+    size_t pointCnt = 0;
+};
+
+inline int aaLineColor(SDL_Renderer *renderer, int x1, int y1, int x2, int y2, SDL_Color color)
+{
+    thread_local AALineBatch batch;
+    batch.addLine(x1, y1, x2, y2);
+    return batch.flush(renderer, color);
+}
+
+/* Add branches of the tree to the batch, recursion stops at branches of 20 or less */
+inline void RenderTreeLines(AALineBatch &batch, int startX, int startY, int lineLength, int lineLengthSeed, int angle, int angleSeed)
+{
     double angleInRad = ((double)angle * M_PI) / 180.0;
 
     int endX = (int)(startX - (double)lineLength * cos(angleInRad));
     int endY = (int)(startY - (double)lineLength * sin(angleInRad));
 
+    batch.addLine(startX, startY, endX, endY);
+
+    if (lineLength > 20)
+    {
+        RenderTreeLines(batch, endX, endY, lineLength - lineLengthSeed, lineLengthSeed, angle + angleSeed, angleSeed);
+        RenderTreeLines(batch, endX, endY, lineLength - lineLengthSeed, lineLengthSeed, angle - angleSeed, angleSeed);
+    }
+}
+
+inline void RenderTree(SDL_Renderer *renderer, int startX, int startY, int lineLength, int lineLengthSeed, int angle, int angleSeed, SDL_Color color = {255, 255, 255, 255})
+{
     // COLOR RANDOMIZER
     // Uint8 re = random(0, 255);
     // Uint8 ge = random(0, 255);
     // Uint8 be = random(0, 255);
     // SDL_Color color = {re, ge, be, 255};
 
-    wuLine(renderer, startX, startY, endX, endY, color);
-
-    if (lineLength > 20)
-    {
-        RenderTree(renderer, endX, endY, lineLength - lineLengthSeed, lineLengthSeed, angle + angleSeed, angleSeed, color);
-        RenderTree(renderer, endX, endY, lineLength - lineLengthSeed, lineLengthSeed, angle - angleSeed, angleSeed, color);
-
-        // Uncomment for a little faster animation
-        // SDL_RenderPresent(renderer);
-    }
+    // whole tree is one batch, so it costs a couple of draw calls however many branches it has
+    thread_local AALineBatch batch;
+    RenderTreeLines(batch, startX, startY, lineLength, lineLengthSeed, angle, angleSeed);
+    batch.flush(renderer, color);
 }
 
 /*
@@ -163,15 +271,6 @@ inline void RenderTree(SDL_Renderer *renderer, int startX, int startY, int lineL
    Richard Russell -- richard at rtrussell dot co dot uk
    */
 
-/*
- *
- * VAR UTILS
- *
- */
-/* CACHE FOR TELLING THINGS IN DRAWING FOR POLYGON */
-static int *primitivesPolyIntsGlobal = NULL;
-static int primitivesPolyAllocatedGlobal = 0;
-
 /*
  *
  * GENERICS UTILS
@@ -181,8 +280,8 @@ inline int vlineRGBA(SDL_Renderer *renderer, int x, int y1, int y2, SDL_Color co
 {
     int result = 0;
     // if (color.a != 255) result |= SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-    result |= SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-    result |= SDL_RenderDrawLine(renderer, x, y1, x, y2);
+    result |= setRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+    result |= renderDrawLine(renderer, x, y1, x, y2);
     return result;
 }
 
@@ -190,19 +289,14 @@ inline int hlineRGBA(SDL_Renderer *renderer, int x1, int x2, int y, SDL_Color co
 {
     int result = 0;
     // if (color.a != 255) result |= SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-    result |= SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-    result |= SDL_RenderDrawLine(renderer, x1, y, x2, y);
+    result |= setRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+    result |= renderDrawLine(renderer, x1, y, x2, y);
     return result;
 }
 
 inline int hline(SDL_Renderer *renderer, int x1, int x2, int y)
 {
-    return SDL_RenderDrawLine(renderer, x1, y, x2, y);
-}
-
-inline int _gfxPrimitivesCompareInt(const void *a, const void *b)
-{
-    return (*(const int *)a) - (*(const int *)b);
+    return renderDrawLine(renderer, x1, y, x2, y);
 }
 
 /*
@@ -210,44 +304,39 @@ inline int _gfxPrimitivesCompareInt(const void *a, const void *b)
  * ELLIPSE FUNCTIONS UTILS
  *
  */
-inline int filledEllipseRGBA(SDL_Renderer *renderer, int x, int y, int rx, int ry, SDL_Color color)
+/* Rows of a filled ellipse centered at (0, 0): x is half width, y is row offset */
+inline void computeEllipseSpanOffsets(int rx, int ry, std::vector<SDL_Point> &offsets)
 {
-    int result;
     int ix, iy;
     int h, i, j, k;
     int oh, oi, oj, ok;
-    int xmh, xph;
-    int xmi, xpi;
-    int xmj, xpj;
-    int xmk, xpk;
 
-    /* Sanity check radius */
+    offsets.clear();
+
+    /* Degenerate radii divide by zero below, same rows as the vline / hline cases of filledEllipseSpans */
     if ((rx < 0) || (ry < 0))
     {
-        return (-1);
+        return;
     }
-
-    /* Special case for rx=0 - draw a vline */
     if (rx == 0)
     {
-        return (vlineRGBA(renderer, x, y - ry, y + ry, color));
+        offsets.push_back({0, 0});
+        for (k = 1; k <= ry; k++)
+        {
+            offsets.push_back({0, k});
+            offsets.push_back({0, -k});
+        }
+        return;
     }
-
-    /* Special case for ry=0 - draw a hline */
     if (ry == 0)
     {
-        return (hlineRGBA(renderer, x - rx, x + rx, y, color));
+        offsets.push_back({rx, 0});
+        return;
     }
 
-    /* Set color */
-    result = 0;
-    // if (color.a != 255) result |= SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-    result |= SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-
     /* Init vars */
     oh = oi = oj = ok = 0xFFFF;
 
-    /* Draw */
     if (rx > ry)
     {
         ix = 0;
@@ -262,31 +351,19 @@ inline int filledEllipseRGBA(SDL_Renderer *renderer, int x, int y, int rx, int r
 
             if ((ok != k) && (oj != k))
             {
-                xph = x + h;
-                xmh = x - h;
+                offsets.push_back({h, k});
                 if (k > 0)
                 {
-                    result |= hline(renderer, xmh, xph, y + k);
-                    result |= hline(renderer, xmh, xph, y - k);
-                }
-                else
-                {
-                    result |= hline(renderer, xmh, xph, y);
+                    offsets.push_back({h, -k});
                 }
                 ok = k;
             }
             if ((oj != j) && (ok != j) && (k != j))
             {
-                xmi = x - i;
-                xpi = x + i;
+                offsets.push_back({i, j});
                 if (j > 0)
                 {
-                    result |= hline(renderer, xmi, xpi, y + j);
-                    result |= hline(renderer, xmi, xpi, y - j);
-                }
-                else
-                {
-                    result |= hline(renderer, xmi, xpi, y);
+                    offsets.push_back({i, -j});
                 }
                 oj = j;
             }
@@ -309,31 +386,19 @@ inline int filledEllipseRGBA(SDL_Renderer *renderer, int x, int y, int rx, int r
 
             if ((oi != i) && (oh != i))
             {
-                xmj = x - j;
-                xpj = x + j;
+                offsets.push_back({j, i});
                 if (i > 0)
                 {
-                    result |= hline(renderer, xmj, xpj, y + i);
-                    result |= hline(renderer, xmj, xpj, y - i);
-                }
-                else
-                {
-                    result |= hline(renderer, xmj, xpj, y);
+                    offsets.push_back({j, -i});
                 }
                 oi = i;
             }
             if ((oh != h) && (oi != h) && (i != h))
             {
-                xmk = x - k;
-                xpk = x + k;
+                offsets.push_back({k, h});
                 if (h > 0)
                 {
-                    result |= hline(renderer, xmk, xpk, y + h);
-                    result |= hline(renderer, xmk, xpk, y - h);
-                }
-                else
-                {
-                    result |= hline(renderer, xmk, xpk, y);
+                    offsets.push_back({k, -h});
                 }
                 oh = h;
             }
@@ -342,6 +407,130 @@ inline int filledEllipseRGBA(SDL_Renderer *renderer, int x, int y, int rx, int r
             iy = iy - ix / ry;
         } while (i > h);
     }
+}
+
+/* Span offsets cached by (rx, ry), so same size ellipses skip the integer stepping */
+inline const std::vector<SDL_Point> &ellipseSpanOffsets(int rx, int ry)
+{
+    static const size_t maxCachedSizes = 512;
+    thread_local std::unordered_map<Uint64, std::vector<SDL_Point>> cache;
+
+    const Uint64 key = ((Uint64)(Uint32)rx << 32) | (Uint32)ry;
+    auto it = cache.find(key);
+    if (it != cache.end())
+    {
+        return it->second;
+    }
+    if (cache.size() >= maxCachedSizes)
+    {
+        cache.clear();
+    }
+    std::vector<SDL_Point> &offsets = cache[key];
+    computeEllipseSpanOffsets(rx, ry, offsets);
+    return offsets;
+}
+
+/* Append rect clipped to clip (if not NULL), nothing when it's outside */
+inline void pushClippedSpan(std::vector<SDL_Rect> &spans, int x, int y, int w, int h, const SDL_Rect *clip)
+{
+    if (clip != NULL)
+    {
+        const int x1 = SDL_min(x + w, clip->x + clip->w);
+        const int y1 = SDL_min(y + h, clip->y + clip->h);
+        x = SDL_max(x, clip->x);
+        y = SDL_max(y, clip->y);
+        w = x1 - x;
+        h = y1 - y;
+        if (w <= 0 || h <= 0)
+        {
+            return;
+        }
+    }
+    spans.push_back({x, y, w, h});
+}
+
+/* Render output or clip rect of the renderer, whichever is smaller, what geometry is clipped to before emission */
+inline SDL_Rect renderClipRect(SDL_Renderer *renderer)
+{
+    SDL_Rect clip = {0, 0, 0, 0};
+    SDL_GetRendererOutputSize(renderer, &clip.w, &clip.h);
+    if (SDL_RenderIsClipEnabled(renderer))
+    {
+        SDL_Rect r;
+        SDL_RenderGetClipRect(renderer, &r);
+        if (!SDL_IntersectRect(&clip, &r, &clip))
+        {
+            clip = {0, 0, 0, 0};
+        }
+    }
+    return clip;
+}
+
+/* Check if the bounds [x0, x1] x [y0, y1] (inclusive) touch the clip rect */
+inline bool boundsVisible(int x0, int y0, int x1, int y1, const SDL_Rect &clip)
+{
+    return x1 >= clip.x && y1 >= clip.y && x0 < clip.x + clip.w && y0 < clip.y + clip.h;
+}
+
+/* Append rows of filled ellipse as 1 pixel high rects, only the part inside clip if given */
+inline int filledEllipseSpans(int x, int y, int rx, int ry, std::vector<SDL_Rect> &spans, const SDL_Rect *clip = NULL)
+{
+    /* Sanity check radius */
+    if ((rx < 0) || (ry < 0))
+    {
+        return (-1);
+    }
+
+    /* Off clip, no rows to step through */
+    if (clip != NULL && !boundsVisible(x - rx, y - ry, x + rx, y + ry, *clip))
+    {
+        return 0;
+    }
+
+    /* Special case for rx=0 - vline */
+    if (rx == 0)
+    {
+        pushClippedSpan(spans, x, y - ry, 1, 2 * ry + 1, clip);
+        return 0;
+    }
+
+    /* Special case for ry=0 - hline */
+    if (ry == 0)
+    {
+        pushClippedSpan(spans, x - rx, y, 2 * rx + 1, 1, clip);
+        return 0;
+    }
+
+    for (const SDL_Point &o : ellipseSpanOffsets(rx, ry))
+    {
+        pushClippedSpan(spans, x - o.x, y + o.y, 2 * o.x + 1, 1, clip);
+    }
+    return 0;
+}
+
+inline int filledEllipseRGBA(SDL_Renderer *renderer, int x, int y, int rx, int ry, SDL_Color color)
+{
+    thread_local std::vector<SDL_Rect> spans;
+    int result;
+
+    spans.clear();
+    const SDL_Rect clip = renderClipRect(renderer);
+    if (filledEllipseSpans(x, y, rx, ry, spans, &clip) != 0)
+    {
+        return (-1);
+    }
+    if (spans.empty())
+    {
+        return 0;
+    }
+
+    /* Set color */
+    result = 0;
+    // if (color.a != 255) result |= SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    result |= setRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+
+    /* Draw all rows at once */
+    result |= renderFillRects(renderer, spans.data(), (int)spans.size());
 
     return (result);
 }
@@ -356,19 +545,27 @@ inline int filledEllipseColor(SDL_Renderer *renderer, int x, int y, int rx, int
  * POLYGON FUNCTIONS UTILS
  *
  */
-inline int filledPolygonRGBAMT(SDL_Renderer *renderer, const int *vx, const int *vy, int n, Uint8 r, Uint8 g, Uint8 b, Uint8 a, int **polyInts, int *polyAllocated)
+/* Polygon edge stepped down the scanlines, intersections are 16.16 fixed point */
+struct PolygonEdge
 {
-    int result;
-    int i;
-    int y, xa, xb;
+    int yBeg, yEnd;       // first and last scanline, inclusive
+    int x1, dx, dy;       // top x, x and y extent
+    int q, rem;           // (65536 * (y - yBeg)) / dy as quotient and remainder
+    int qStep, remStep;
+    int x;                // intersection at current scanline
+};
+
+/* Append scanlines of filled polygon as 1 pixel high rects.
+   Edges come from an edge table sorted by top y and are stepped incrementally, the active list is kept
+   sorted with insertion sort, so the cost is linear in rows and spans. Pixels match SDL2_gfx filledPolygonRGBAMT.
+   With clip only its rows are scanned and spans are cut to it. */
+inline int filledPolygonSpans(const int *vx, const int *vy, int n, std::vector<SDL_Rect> &spans, const SDL_Rect *clip = NULL)
+{
+    int i, y, xa, xb;
+    int minx, maxx;
     int miny, maxy;
     int x1, y1;
     int x2, y2;
-    int ind1, ind2;
-    int ints;
-    int *gfxPrimitivesPolyInts = NULL;
-    int *gfxPrimitivesPolyIntsNew = NULL;
-    int gfxPrimitivesPolyAllocated = 0;
 
     /* Vertex array NULL check */
     if (vx == NULL)
@@ -386,204 +583,335 @@ inline int filledPolygonRGBAMT(SDL_Renderer *renderer, const int *vx, const int
         return -1;
     }
 
-    /* Map polygon cache */
-    if ((polyInts == NULL) || (polyAllocated == NULL))
-    {
-        /* Use global cache */
-        gfxPrimitivesPolyInts = primitivesPolyIntsGlobal;
-        gfxPrimitivesPolyAllocated = primitivesPolyAllocatedGlobal;
-    }
-    else
-    {
-        /* Use local cache */
-        gfxPrimitivesPolyInts = *polyInts;
-        gfxPrimitivesPolyAllocated = *polyAllocated;
-    }
-
-    /* Allocate temp array, only grow array */
-    if (!gfxPrimitivesPolyAllocated)
-    {
-        gfxPrimitivesPolyInts = (int *)malloc(sizeof(int) * n);
-        gfxPrimitivesPolyAllocated = n;
-    }
-    else
+    /* Determine X and Y maxima, spans stay within them */
+    minx = vx[0];
+    maxx = vx[0];
+    miny = vy[0];
+    maxy = vy[0];
+    for (i = 1; (i < n); i++)
     {
-        if (gfxPrimitivesPolyAllocated < n)
+        minx = SDL_min(minx, vx[i]);
+        maxx = SDL_max(maxx, vx[i]);
+        if (vy[i] < miny)
         {
-            gfxPrimitivesPolyIntsNew = (int *)realloc(gfxPrimitivesPolyInts, sizeof(int) * n);
-            if (!gfxPrimitivesPolyIntsNew)
-            {
-                if (!gfxPrimitivesPolyInts)
-                {
-                    free(gfxPrimitivesPolyInts);
-                    gfxPrimitivesPolyInts = NULL;
-                }
-                gfxPrimitivesPolyAllocated = 0;
-            }
-            else
-            {
-                gfxPrimitivesPolyInts = gfxPrimitivesPolyIntsNew;
-                gfxPrimitivesPolyAllocated = n;
-            }
+            miny = vy[i];
+        }
+        else if (vy[i] > maxy)
+        {
+            maxy = vy[i];
         }
     }
 
-    /* Check temp array */
-    if (gfxPrimitivesPolyInts == NULL)
-    {
-        gfxPrimitivesPolyAllocated = 0;
-    }
-
-    /* Update cache variables */
-    if ((polyInts == NULL) || (polyAllocated == NULL))
+    /* Scanlines inside clip, nothing to do when the polygon is off it */
+    int firstY = miny;
+    int lastY = maxy;
+    if (clip != NULL)
     {
-        primitivesPolyIntsGlobal = gfxPrimitivesPolyInts;
-        primitivesPolyAllocatedGlobal = gfxPrimitivesPolyAllocated;
-    }
-    else
-    {
-        *polyInts = gfxPrimitivesPolyInts;
-        *polyAllocated = gfxPrimitivesPolyAllocated;
+        if (!boundsVisible(minx, miny, maxx, maxy, *clip))
+        {
+            return 0;
+        }
+        firstY = SDL_max(miny, clip->y);
+        lastY = SDL_min(maxy, clip->y + clip->h - 1);
     }
 
-    /* Check temp array again */
-    if (gfxPrimitivesPolyInts == NULL)
-    {
-        return (-1);
-    }
+    /* Edge table and active list live in the thread's frame arena */
+    FrameArena &arena = FrameArena::local();
+    FrameArena::Scope scope(arena);
+    PolygonEdge *edges = arena.alloc<PolygonEdge>(n);
+    PolygonEdge **active = arena.alloc<PolygonEdge *>(n);
+    int edgeCnt = 0;
+    int activeCnt = 0;
 
-    /* Determine Y maxima */
-    miny = vy[0];
-    maxy = vy[0];
-    for (i = 1; (i < n); i++)
+    /* Build edge table, horizontal edges never intersect a scanline */
+    for (i = 0; (i < n); i++)
     {
-        if (vy[i] < miny)
+        x1 = vx[i ? i - 1 : n - 1];
+        y1 = vy[i ? i - 1 : n - 1];
+        x2 = vx[i];
+        y2 = vy[i];
+        if (y1 == y2)
         {
-            miny = vy[i];
+            continue;
         }
-        else if (vy[i] > maxy)
+        if (y1 > y2)
         {
-            maxy = vy[i];
+            std::swap(x1, x2);
+            std::swap(y1, y2);
         }
+
+        PolygonEdge &e = edges[edgeCnt++];
+        e.yBeg = y1;
+        e.yEnd = y2 == maxy ? y2 : y2 - 1; // the bottom scanline is closed by the edges ending on it
+        e.x1 = x1;
+        e.dx = x2 - x1;
+        e.dy = y2 - y1;
+        e.q = 0;
+        e.rem = 0;
+        e.qStep = 65536 / e.dy;
+        e.remStep = 65536 % e.dy;
+        e.x = 0;
     }
+    std::sort(edges, edges + edgeCnt, [](const PolygonEdge &a, const PolygonEdge &b) { return a.yBeg < b.yBeg; });
 
     /* Draw, scanning y */
-    result = 0;
-    for (y = miny; (y <= maxy); y++)
+    int next = 0;
+    for (y = firstY; (y <= lastY); y++)
     {
-        ints = 0;
-        for (i = 0; (i < n); i++)
+        /* Edges starting here join, finished ones leave. Above the clip they join stepped to this row */
+        while (next < edgeCnt && edges[next].yBeg <= y)
         {
-            if (!i)
-            {
-                ind1 = n - 1;
-                ind2 = 0;
-            }
-            else
-            {
-                ind1 = i - 1;
-                ind2 = i;
-            }
-            y1 = vy[ind1];
-            y2 = vy[ind2];
-            if (y1 < y2)
+            PolygonEdge *e = &edges[next++];
+            const Sint64 steps = 65536 * (Sint64)(y - e->yBeg);
+            e->q = (int)(steps / e->dy);
+            e->rem = (int)(steps % e->dy);
+            active[activeCnt++] = e;
+        }
+        int cnt = 0;
+        for (int k = 0; k < activeCnt; k++)
+        {
+            if (active[k]->yEnd >= y)
             {
-                x1 = vx[ind1];
-                x2 = vx[ind2];
+                active[cnt++] = active[k];
             }
-            else if (y1 > y2)
+        }
+        activeCnt = cnt;
+
+        /* Intersections, order changes only where edges cross so insertion sort is near linear */
+        for (int k = 0; k < cnt; k++)
+        {
+            PolygonEdge *e = active[k];
+            e->x = e->q * e->dx + (65536 * e->x1);
+
+            int j = k;
+            while (j > 0 && active[j - 1]->x > e->x)
             {
-                y2 = vy[ind1];
-                y1 = vy[ind2];
-                x2 = vx[ind1];
-                x1 = vx[ind2];
+                active[j] = active[j - 1];
+                j--;
             }
-            else
+            active[j] = e;
+        }
+
+        for (int k = 0; k + 1 < cnt; k += 2)
+        {
+            xa = active[k]->x + 1;
+            xa = (xa >> 16) + ((xa & 32768) >> 15);
+            xb = active[k + 1]->x - 1;
+            xb = (xb >> 16) + ((xb & 32768) >> 15);
+            /* Same pixels as hline from xa to xb */
+            if (xa > xb)
             {
-                continue;
+                std::swap(xa, xb);
             }
-            if (((y >= y1) && (y < y2)) || ((y == maxy) && (y > y1) && (y <= y2)))
+            pushClippedSpan(spans, xa, y, xb - xa + 1, 1, clip);
+        }
+
+        for (int k = 0; k < cnt; k++)
+        {
+            PolygonEdge *e = active[k];
+            e->q += e->qStep;
+            e->rem += e->remStep;
+            if (e->rem >= e->dy)
             {
-                gfxPrimitivesPolyInts[ints++] = ((65536 * (y - y1)) / (y2 - y1)) * (x2 - x1) + (65536 * x1);
+                e->q++;
+                e->rem -= e->dy;
             }
         }
+    }
 
-        qsort(gfxPrimitivesPolyInts, ints, sizeof(int), _gfxPrimitivesCompareInt);
+    return 0;
+}
 
-        /* Set color */
-        result = 0;
-        if (a != 255)
-            result |= SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-        result |= SDL_SetRenderDrawColor(renderer, r, g, b, a);
+inline int filledPolygonRGBA(SDL_Renderer *renderer, const int *vx, const int *vy, int n, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    thread_local std::vector<SDL_Rect> spans;
+    int result;
 
-        for (i = 0; (i < ints); i += 2)
-        {
-            xa = gfxPrimitivesPolyInts[i] + 1;
-            xa = (xa >> 16) + ((xa & 32768) >> 15);
-            xb = gfxPrimitivesPolyInts[i + 1] - 1;
-            xb = (xb >> 16) + ((xb & 32768) >> 15);
-            result |= hline(renderer, xa, xb, y);
-        }
+    spans.clear();
+    const SDL_Rect clip = renderClipRect(renderer);
+    if (filledPolygonSpans(vx, vy, n, spans, &clip) != 0)
+    {
+        return (-1);
     }
+    if (spans.empty())
+    {
+        return 0;
+    }
+
+    /* Set color once */
+    result = 0;
+    if (a != 255)
+        result |= setRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    result |= setRenderDrawColor(renderer, r, g, b, a);
+
+    /* Draw all scanlines at once */
+    result |= renderFillRects(renderer, spans.data(), (int)spans.size());
 
     return (result);
 }
 
 inline int filledPolygonColor(SDL_Renderer *renderer, const int *vx, const int *vy, int n, SDL_Color color)
 {
-    return filledPolygonRGBAMT(renderer, vx, vy, n, color.r, color.g, color.b, color.a, NULL, NULL);
+    return filledPolygonRGBA(renderer, vx, vy, n, color.r, color.g, color.b, color.a);
 }
 
 /*
  *
- * ELLIPSE BORDER UTILS: Draw one quadrant arc, and mirror the other 4 quadrants
+ * ELLIPSE BORDER UTILS: One quadrant arc from a table, mirrored into the other quadrants
  *
  */
-inline void borderEllipse(SDL_Renderer *r, int x0, int y0, int radiusX, int radiusY, SDL_Color color)
+/* cosf / sinf of the quadrant steps, theta accumulated in float like the original loop */
+struct EllipseArcTable
+{
+    static const int k_prec = 27; // precision value; value of 1 will draw a diamond, 27 makes pretty smooth circles.
+    float cosT[k_prec + 2];
+    float sinT[k_prec + 2];
+    int cnt;
+};
+
+inline const EllipseArcTable &ellipseArcTable()
+{
+    static const EllipseArcTable table = []() {
+        EllipseArcTable t;
+        float pi = 3.14159265358979323846264338327950288419716939937510;
+        float pih = pi / 2.0;                           //half of pi
+        float step = pih / (float)EllipseArcTable::k_prec; // amount to add to theta each time
+        t.cnt = 0;
+        for (float theta = step; theta <= pih && t.cnt < EllipseArcTable::k_prec + 2; theta += step)
+        {
+            t.cosT[t.cnt] = cosf(theta);
+            t.sinT[t.cnt] = sinf(theta);
+            t.cnt++;
+        }
+        return t;
+    }();
+    return table;
+}
+
+/* Append Bresenham line as 1 pixel high (or wide) rects, one per run of pixels on the same row (column).
+   Both ends are included unless drawEnd is false, so polylines can skip their shared points. */
+inline void lineRuns(int x1, int y1, int x2, int y2, bool drawEnd, std::vector<SDL_Rect> &runs)
+{
+    const int dx = abs(x2 - x1);
+    const int dy = abs(y2 - y1);
+    const int sx = x1 < x2 ? 1 : -1;
+    const int sy = y1 < y2 ? 1 : -1;
+    const int cnt = SDL_max(dx, dy) + (drawEnd ? 1 : 0);
+
+    if (dx >= dy)
+    {
+        int err = dx / 2;
+        int runX = x1, x = x1, y = y1;
+        for (int i = 0; i < cnt; ++i)
+        {
+            const bool last = i + 1 == cnt;
+            err -= dy;
+            if (last || err < 0)
+            {
+                runs.push_back({SDL_min(runX, x), y, abs(x - runX) + 1, 1});
+                y += sy;
+                err += dx;
+                runX = x + sx;
+            }
+            x += sx;
+        }
+    }
+    else
+    {
+        int err = dy / 2;
+        int runY = y1, x = x1, y = y1;
+        for (int i = 0; i < cnt; ++i)
+        {
+            const bool last = i + 1 == cnt;
+            err -= dx;
+            if (last || err < 0)
+            {
+                runs.push_back({x, SDL_min(runY, y), 1, abs(y - runY) + 1});
+                x += sx;
+                err += dy;
+                runY = y + sy;
+            }
+            y += sy;
+        }
+    }
+}
+
+/* Append closed outline of ellipse as one polyline: quadrant arc from the table mirrored 4 times */
+inline void borderEllipsePoints(int x0, int y0, int radiusX, int radiusY, std::vector<SDL_Point> &points)
 {
-    float pi = 3.14159265358979323846264338327950288419716939937510;
-    float pih = pi / 2.0; //half of pi
-
-    //drew  28 lines with   4x4  circle with precision of 150 0ms
-    //drew 132 lines with  25x14 circle with precision of 150 0ms
-    //drew 152 lines with 100x50 circle with precision of 150 3ms
-    const int prec = 27; // precision value; value of 1 will draw a diamond, 27 makes pretty smooth circles.
-    float theta = 0;     // angle that will be increased each loop
-
-    //starting point
-    int x = (float)radiusX * cos(theta); //start point
-    int y = (float)radiusY * sin(theta); //start point
-    int x1 = x;
-    int y1 = y;
-
-    SDL_SetRenderDrawColor(r, color.r, color.g, color.b, 255);
-    //repeat until theta >= 90;
-    float step = pih / (float)prec;                 // amount to add to theta each time (degrees)
-    for (theta = step; theta <= pih; theta += step) //step through only a 90 arc (1 quadrant)
-    {
-        //get new point location
-        x1 = (float)radiusX * cosf(theta) + 0.5; //new point (+.5 is a quick rounding method)
-        y1 = (float)radiusY * sinf(theta) + 0.5; //new point (+.5 is a quick rounding method)
-
-        //draw line from previous point to new point, ONLY if point incremented
-        if ((x != x1) || (y != y1)) //only draw if coordinate changed
+    const EllipseArcTable &table = ellipseArcTable();
+
+    // quadrant arc from (radiusX, 0) to (0, radiusY), only points where the coordinate changed
+    SDL_Point arc[EllipseArcTable::k_prec + 4];
+    int n = 0;
+    arc[n++] = {radiusX, 0};
+    for (int i = 0; i < table.cnt; i++)
+    {
+        const int x1 = (float)radiusX * table.cosT[i] + 0.5; //new point (+.5 is a quick rounding method)
+        const int y1 = (float)radiusY * table.sinT[i] + 0.5; //new point (+.5 is a quick rounding method)
+        if ((arc[n - 1].x != x1) || (arc[n - 1].y != y1))
         {
-            SDL_RenderDrawLine(r, x0 + x, y0 - y, x0 + x1, y0 - y1); //quadrant TR
-            SDL_RenderDrawLine(r, x0 - x, y0 - y, x0 - x1, y0 - y1); //quadrant TL
-            SDL_RenderDrawLine(r, x0 - x, y0 + y, x0 - x1, y0 + y1); //quadrant BL
-            SDL_RenderDrawLine(r, x0 + x, y0 + y, x0 + x1, y0 + y1); //quadrant BR
+            arc[n++] = {x1, y1};
         }
-        //save previous points
-        x = x1; //save new previous point
-        y = y1; //save new previous point
     }
     //arc did not finish because of rounding, so finish the arc
-    if (x != 0)
+    if (arc[n - 1].x != 0)
+    {
+        arc[n] = {0, arc[n - 1].y};
+        n++;
+    }
+
+    // TR forward, TL backward, BL forward, BR backward ends at the start point
+    for (int i = 0; i < n; i++)
+    {
+        points.push_back({x0 + arc[i].x, y0 - arc[i].y});
+    }
+    for (int i = n - 2; i >= 0; i--)
+    {
+        points.push_back({x0 - arc[i].x, y0 - arc[i].y});
+    }
+    for (int i = 1; i < n; i++)
     {
-        x = 0;
-        SDL_RenderDrawLine(r, x0 + x, y0 - y, x0 + x1, y0 - y1); //quadrant TR
-        SDL_RenderDrawLine(r, x0 - x, y0 - y, x0 - x1, y0 - y1); //quadrant TL
-        SDL_RenderDrawLine(r, x0 - x, y0 + y, x0 - x1, y0 + y1); //quadrant BL
-        SDL_RenderDrawLine(r, x0 + x, y0 + y, x0 + x1, y0 + y1); //quadrant BR
+        points.push_back({x0 - arc[i].x, y0 + arc[i].y});
+    }
+    for (int i = n - 2; i >= 0; i--)
+    {
+        points.push_back({x0 + arc[i].x, y0 + arc[i].y});
+    }
+}
+
+inline void borderEllipse(SDL_Renderer *r, int x0, int y0, int radiusX, int radiusY, SDL_Color color)
+{
+    thread_local std::vector<SDL_Point> points;
+    points.clear();
+    borderEllipsePoints(x0, y0, radiusX, radiusY, points);
+
+    setRenderDrawColor(r, color.r, color.g, color.b, 255);
+    renderDrawLines(r, points.data(), (int)points.size());
+}
+
+/* Rings of radius, 2 * radius, ... count * radius sharing one color setup, rings off the viewport are skipped */
+inline void borderEllipseRings(SDL_Renderer *r, int x0, int y0, int radius, int count, SDL_Color color)
+{
+    thread_local std::vector<SDL_Point> points;
+
+    const SDL_Rect clip = renderClipRect(r);
+    bool colorSet = false;
+    for (int i = 1; i <= count; i++)
+    {
+        // an inner ring can miss the viewport while outer ones cross it
+        const int ringR = i * radius;
+        if (!boundsVisible(x0 - ringR, y0 - ringR, x0 + ringR, y0 + ringR, clip))
+        {
+            continue;
+        }
+        if (!colorSet)
+        {
+            setRenderDrawColor(r, color.r, color.g, color.b, 255);
+            colorSet = true;
+        }
+        points.clear();
+        borderEllipsePoints(x0, y0, ringR, ringR, points);
+        renderDrawLines(r, points.data(), (int)points.size());
     }
 }
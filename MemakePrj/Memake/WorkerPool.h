@@ -0,0 +1,131 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <functional>
+
+#include "FrameArena.h"
+
+/**
+ * Persistent worker threads for data parallel loops.
+ * The calling thread takes part in the work, parallelFor calls must not be nested.
+ * Workers' FrameArena is reset after every parallelFor, so task scratch lives until the loop ends.
+ */
+class WorkerPool
+{
+public:
+    explicit WorkerPool(unsigned int thrCnt = std::thread::hardware_concurrency())
+    {
+        // calling thread is one of the workers
+        for (unsigned int i = 1; i < thrCnt; ++i)
+        {
+            workers.push_back(std::thread(&WorkerPool::workerLoop, this));
+        }
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        wakeCv.notify_all();
+        for (std::thread &t : workers)
+        {
+            t.join();
+        }
+    }
+
+    unsigned int getThreadCnt() const
+    {
+        return (unsigned int)workers.size() + 1;
+    }
+
+    /**
+     * Run task(i) for every i in [0, cnt), returns when all of them are done.
+     */
+    void parallelFor(int cnt, const std::function<void(int)> &task)
+    {
+        if (cnt <= 0)
+        {
+            return;
+        }
+        if (workers.empty() || cnt == 1)
+        {
+            for (int i = 0; i < cnt; ++i)
+            {
+                task(i);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            curTask = &task;
+            taskCnt = cnt;
+            nextIdx = 0;
+            busyCnt = (int)workers.size();
+            ++generation;
+        }
+        wakeCv.notify_all();
+
+        runItems(task, cnt);
+
+        std::unique_lock<std::mutex> lock(mtx);
+        doneCv.wait(lock, [this]() { return busyCnt == 0; });
+        curTask = nullptr;
+    }
+
+private:
+    void runItems(const std::function<void(int)> &task, int cnt)
+    {
+        for (int i = nextIdx++; i < cnt; i = nextIdx++)
+        {
+            task(i);
+        }
+    }
+
+    void workerLoop()
+    {
+        unsigned int seenGeneration = 0;
+        for (;;)
+        {
+            const std::function<void(int)> *task;
+            int cnt;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                wakeCv.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+                if (stopping)
+                {
+                    return;
+                }
+                seenGeneration = generation;
+                task = curTask;
+                cnt = taskCnt;
+            }
+
+            runItems(*task, cnt);
+            FrameArena::local().reset();
+
+            std::lock_guard<std::mutex> lock(mtx);
+            if (--busyCnt == 0)
+            {
+                doneCv.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mtx;
+    std::condition_variable wakeCv;
+    std::condition_variable doneCv;
+    const std::function<void(int)> *curTask = nullptr;
+    std::atomic<int> nextIdx{0};
+    int taskCnt = 0;
+    int busyCnt = 0;
+    unsigned int generation = 0;
+    bool stopping = false;
+};
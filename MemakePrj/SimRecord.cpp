@@ -0,0 +1,469 @@
+#include "SimRecord.h"
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Delta payload is XOR against the previous frame stored as runs of
+// [zero words count, literal words count, literal words...]
+static void encodeDelta(const uint32_t* cur, const uint32_t* prev, size_t words, std::vector<uint32_t>& out)
+{
+    out.clear();
+    size_t i = 0;
+    while (i < words)
+    {
+        uint32_t zeros = 0;
+        while (i < words && cur[i] == prev[i])
+        {
+            ++zeros;
+            ++i;
+        }
+        size_t litCntPos = out.size() + 1;
+        out.push_back(zeros);
+        out.push_back(0);
+        while (i < words && cur[i] != prev[i])
+        {
+            out.push_back(cur[i] ^ prev[i]);
+            ++i;
+        }
+        out[litCntPos] = (uint32_t)(out.size() - litCntPos - 1);
+    }
+}
+
+static bool applyDelta(const uint32_t* in, size_t inWords, uint32_t* frame, size_t words)
+{
+    size_t pos = 0;
+    size_t i = 0;
+    while (i + 2 <= inWords)
+    {
+        pos += in[i++];
+        uint32_t lits = in[i++];
+        if (pos + lits > words || i + lits > inWords)
+        {
+            return false;
+        }
+        for (uint32_t k = 0; k < lits; ++k)
+        {
+            frame[pos++] ^= in[i++];
+        }
+    }
+    return true;
+}
+
+// ============================================================================
+// SimRecorder
+// ============================================================================
+
+SimRecorder::~SimRecorder()
+{
+    close();
+}
+
+bool SimRecorder::open(const std::string& path, uint32_t frameSize, uint32_t frameStep, bool delta, uint32_t keyFrameInterval, size_t queueDepth)
+{
+    close();
+
+    // delta works on 32-bit words
+    if (frameSize == 0 || frameSize % sizeof(uint32_t) != 0)
+    {
+        return false;
+    }
+
+    file.open(path, std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!file)
+    {
+        return false;
+    }
+
+    header = SimRecordHeader();
+    header.frameSize = frameSize;
+    header.frameStep = frameStep > 0 ? frameStep : 1;
+    header.flags = delta ? (uint32_t)SimRecordDelta : 0u;
+    header.keyFrameInterval = delta && keyFrameInterval > 0 ? keyFrameInterval : 1;
+    file.write((const char*)&header, sizeof(header));
+    file.flush();
+    if (!file.good())
+    {
+        file.close();
+        return false;
+    }
+    fileOffset = sizeof(header);
+
+    index.clear();
+    prevFrame.assign(frameSize, 0);
+    freeBufs.assign(queueDepth > 0 ? queueDepth : 1, std::vector<uint8_t>(frameSize));
+    pending.clear();
+    stopping = false;
+    droppedCnt = 0;
+    writeFailed = false;
+    writer = std::thread(&SimRecorder::writerLoop, this);
+    return true;
+}
+
+void SimRecorder::submit(uint64_t simFrame, const void* data)
+{
+    if (!isOpen() || simFrame % header.frameStep != 0)
+    {
+        return;
+    }
+
+    PendingFrame frame;
+    frame.simFrame = simFrame;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (freeBufs.empty() || writeFailed)
+        {
+            // writer is behind or gone, don't wait for it
+            ++droppedCnt;
+            return;
+        }
+        frame.data = std::move(freeBufs.back());
+        freeBufs.pop_back();
+    }
+
+    memcpy(frame.data.data(), data, header.frameSize);
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending.push_back(std::move(frame));
+    }
+    cv.notify_one();
+}
+
+void SimRecorder::close()
+{
+    if (!isOpen())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    cv.notify_one();
+    writer.join();
+
+    // trailing index after the last whole frame, then patch header to point at it;
+    // if the index doesn't fit the reader rebuilds it from the frames before indexOffset
+    file.clear();
+    file.seekp(fileOffset);
+    header.frameCnt = index.size();
+    header.indexOffset = fileOffset;
+    file.write((const char*)index.data(), index.size() * sizeof(SimFrameIndex));
+    if (!file.good())
+    {
+        writeFailed = true;
+        file.clear();
+    }
+    file.seekp(0);
+    file.write((const char*)&header, sizeof(header));
+    if (!file.good())
+    {
+        writeFailed = true;
+    }
+    file.close();
+}
+
+void SimRecorder::writerLoop()
+{
+    for (;;)
+    {
+        PendingFrame frame;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this]() { return stopping || !pending.empty(); });
+            if (pending.empty())
+            {
+                return;
+            }
+            frame = std::move(pending.front());
+            pending.pop_front();
+        }
+
+        if (!writeFrame(frame))
+        {
+            // index keeps the frames written so far, the rest is dropped
+            std::lock_guard<std::mutex> lock(mtx);
+            writeFailed = true;
+            droppedCnt += 1 + pending.size();
+            pending.clear();
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        freeBufs.push_back(std::move(frame.data));
+    }
+}
+
+bool SimRecorder::writeFrame(const PendingFrame& frame)
+{
+    const size_t words = header.frameSize / sizeof(uint32_t);
+    const bool isKey = (index.size() % header.keyFrameInterval) == 0;
+
+    SimFrameHeader fh;
+    fh.simFrame = frame.simFrame;
+    const char* payload = (const char*)frame.data.data();
+    fh.payloadSize = header.frameSize;
+    if (!isKey)
+    {
+        encodeDelta((const uint32_t*)frame.data.data(), (const uint32_t*)prevFrame.data(), words, encoded);
+        // fall back to raw frame when delta doesn't pay off
+        if (encoded.size() < words)
+        {
+            fh.isDelta = 1;
+            fh.payloadSize = (uint32_t)(encoded.size() * sizeof(uint32_t));
+            payload = (const char*)encoded.data();
+        }
+    }
+
+    file.write((const char*)&fh, sizeof(fh));
+    file.write(payload, fh.payloadSize);
+    // flush so a failed write is seen here and not by a later frame already in the index
+    file.flush();
+    if (!file.good())
+    {
+        return false;
+    }
+    index.push_back({ fh.simFrame, fileOffset });
+    fileOffset += sizeof(fh) + fh.payloadSize;
+
+    if (header.flags & SimRecordDelta)
+    {
+        memcpy(prevFrame.data(), frame.data.data(), header.frameSize);
+    }
+    return true;
+}
+
+// ============================================================================
+// SimReplay
+// ============================================================================
+
+SimReplay::~SimReplay()
+{
+    close();
+}
+
+bool SimReplay::map(const std::string& path)
+{
+#ifdef _WIN32
+    fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+    {
+        fileHandle = nullptr;
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+    {
+        return false;
+    }
+    size = (size_t)fileSize.QuadPart;
+    mapHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapHandle == NULL)
+    {
+        return false;
+    }
+    data = (const uint8_t*)MapViewOfFile(mapHandle, FILE_MAP_READ, 0, 0, 0);
+    return data != nullptr;
+#else
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        return false;
+    }
+    size = (size_t)st.st_size;
+    void* p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+    {
+        return false;
+    }
+    data = (const uint8_t*)p;
+    return true;
+#endif
+}
+
+void SimReplay::unmap()
+{
+#ifdef _WIN32
+    if (data)
+    {
+        UnmapViewOfFile(data);
+    }
+    if (mapHandle)
+    {
+        CloseHandle(mapHandle);
+    }
+    if (fileHandle)
+    {
+        CloseHandle(fileHandle);
+    }
+    mapHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    if (data)
+    {
+        munmap((void*)data, size);
+    }
+    if (fd >= 0)
+    {
+        ::close(fd);
+    }
+    fd = -1;
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+bool SimReplay::open(const std::string& path)
+{
+    close();
+    if (!map(path) || size < sizeof(SimRecordHeader))
+    {
+        close();
+        return false;
+    }
+
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != k_simRecordMagic || header.version != k_simRecordVersion || header.frameSize == 0)
+    {
+        close();
+        return false;
+    }
+
+    // index must lie between the frames and the end of file, compared without overflowing
+    const bool indexStarts = header.indexOffset >= sizeof(SimRecordHeader) && header.indexOffset <= size;
+    const bool indexFits = indexStarts && header.frameCnt <= (size - header.indexOffset) / sizeof(SimFrameIndex);
+    if (indexFits)
+    {
+        index.resize((size_t)header.frameCnt);
+        memcpy(index.data(), data + header.indexOffset, index.size() * sizeof(SimFrameIndex));
+    }
+    if (!indexFits || !checkIndex())
+    {
+        // writer didn't finish or the index is corrupt, rebuild it by walking the frames
+        index.clear();
+        const uint64_t end = indexStarts ? header.indexOffset : size;
+        uint64_t offset = sizeof(SimRecordHeader);
+        SimFrameHeader fh;
+        while (readFrameHeader(offset, end, fh))
+        {
+            index.push_back({ fh.simFrame, offset });
+            offset += sizeof(fh) + fh.payloadSize;
+        }
+    }
+
+    cur.assign(header.frameSize, 0);
+    curK = SIZE_MAX;
+    return true;
+}
+
+void SimReplay::close()
+{
+    unmap();
+    index.clear();
+    cur.clear();
+    curK = SIZE_MAX;
+}
+
+// Header of the frame at offset, false unless the frame and its payload end by end.
+bool SimReplay::readFrameHeader(uint64_t offset, uint64_t end, SimFrameHeader& fh) const
+{
+    // payloads are read as 32-bit words
+    if (offset % sizeof(uint32_t) != 0 || offset > end || end - offset < sizeof(SimFrameHeader))
+    {
+        return false;
+    }
+    memcpy(&fh, data + offset, sizeof(fh));
+    return fh.payloadSize <= end - offset - sizeof(SimFrameHeader);
+}
+
+// Every index entry points at a whole frame before the index, in file order.
+bool SimReplay::checkIndex() const
+{
+    uint64_t prevEnd = sizeof(SimRecordHeader);
+    for (const SimFrameIndex& e : index)
+    {
+        SimFrameHeader fh;
+        if (e.offset < prevEnd || !readFrameHeader(e.offset, header.indexOffset, fh) || fh.simFrame != e.simFrame)
+        {
+            return false;
+        }
+        prevEnd = e.offset + sizeof(fh) + fh.payloadSize;
+    }
+    return true;
+}
+
+const SimFrameHeader* SimReplay::frameAt(size_t k) const
+{
+    return (const SimFrameHeader*)(data + index[k].offset);
+}
+
+bool SimReplay::readFrame(size_t k, void* out)
+{
+    if (k >= index.size())
+    {
+        return false;
+    }
+
+    // nearest key frame at or before k
+    size_t from = k;
+    SimFrameHeader fh;
+    for (;;)
+    {
+        memcpy(&fh, frameAt(from), sizeof(fh));
+        if (!fh.isDelta || from == 0)
+        {
+            break;
+        }
+        --from;
+    }
+
+    // continue from the last decoded frame when replaying forward
+    if (curK != SIZE_MAX && curK >= from && curK <= k)
+    {
+        from = curK + 1;
+    }
+
+    // payloads are 32-bit aligned: header sizes and payload sizes are multiples of 4
+    const size_t words = header.frameSize / sizeof(uint32_t);
+    for (size_t i = from; i <= k; ++i)
+    {
+        memcpy(&fh, frameAt(i), sizeof(fh));
+        const uint8_t* payload = (const uint8_t*)frameAt(i) + sizeof(SimFrameHeader);
+        if (fh.isDelta)
+        {
+            if (!applyDelta((const uint32_t*)payload, fh.payloadSize / sizeof(uint32_t), (uint32_t*)cur.data(), words))
+            {
+                curK = SIZE_MAX;
+                return false;
+            }
+        }
+        else if (fh.payloadSize == header.frameSize)
+        {
+            memcpy(cur.data(), payload, header.frameSize);
+        }
+        else
+        {
+            curK = SIZE_MAX;
+            return false;
+        }
+        curK = i;
+    }
+
+    memcpy(out, cur.data(), header.frameSize);
+    return true;
+}
@@ -0,0 +1,136 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// Simulation record file layout:
+//   SimRecordHeader
+//   frames: SimFrameHeader + payload (raw frame or delta against previous stored frame)
+//   index:  SimFrameIndex[frameCnt], written on close and pointed by header.indexOffset
+// A file without index (writer was not closed) is still readable by scanning frames.
+
+static const uint32_t k_simRecordMagic = 0x4D495342; // "BSIM"
+static const uint32_t k_simRecordVersion = 1;
+
+enum SimRecordFlags : uint32_t
+{
+    SimRecordDelta = 1 << 0, // frames between key frames are delta encoded
+};
+
+#pragma pack(push, 1)
+struct SimRecordHeader
+{
+    uint32_t magic = k_simRecordMagic;
+    uint32_t version = k_simRecordVersion;
+    uint32_t frameSize = 0;        // bytes of one decoded frame
+    uint32_t frameStep = 1;        // every Nth simulation frame is stored
+    uint32_t flags = 0;            // SimRecordFlags
+    uint32_t keyFrameInterval = 1; // every Nth stored frame is a raw key frame
+    uint64_t frameCnt = 0;         // stored frames, valid when indexOffset != 0
+    uint64_t indexOffset = 0;      // 0 until the writer is closed
+};
+
+struct SimFrameHeader
+{
+    uint64_t simFrame = 0;         // simulation frame number
+    uint32_t payloadSize = 0;      // bytes following this header
+    uint32_t isDelta = 0;          // payload is delta against previous stored frame
+};
+
+struct SimFrameIndex
+{
+    uint64_t simFrame = 0;
+    uint64_t offset = 0;           // file offset of SimFrameHeader
+};
+#pragma pack(pop)
+
+// Appends every Nth submitted frame to a record file.
+// Frames are copied into a pool of buffers and written by a background thread,
+// if the pool is exhausted the frame is dropped instead of blocking the caller.
+// A failed write (e.g. full disk) stops the writer, the file keeps the frames written
+// before it and every later frame counts as dropped.
+class SimRecorder
+{
+public:
+    SimRecorder() = default;
+    ~SimRecorder();
+
+    bool open(const std::string& path, uint32_t frameSize, uint32_t frameStep = 1,
+              bool delta = false, uint32_t keyFrameInterval = 64, size_t queueDepth = 8);
+    void submit(uint64_t simFrame, const void* data);
+    void close();
+
+    bool isOpen() const { return writer.joinable(); }
+    uint64_t getDroppedCnt() const { return droppedCnt; }
+    bool hasWriteFailed() const { return writeFailed; }
+
+private:
+    struct PendingFrame
+    {
+        uint64_t simFrame;
+        std::vector<uint8_t> data;
+    };
+
+    void writerLoop();
+    bool writeFrame(const PendingFrame& frame);
+
+    std::ofstream file;
+    SimRecordHeader header;
+    std::vector<SimFrameIndex> index;
+    std::vector<uint8_t> prevFrame;   // last stored frame, base for delta
+    std::vector<uint32_t> encoded;    // delta encoding scratch
+    uint64_t fileOffset = 0;
+
+    std::vector<std::vector<uint8_t>> freeBufs;
+    std::deque<PendingFrame> pending;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::thread writer;
+    bool stopping = false;
+    std::atomic<uint64_t> droppedCnt{ 0 };
+    std::atomic<bool> writeFailed{ false };
+};
+
+// Random access reader of a record file, the file is memory mapped.
+class SimReplay
+{
+public:
+    SimReplay() = default;
+    ~SimReplay();
+
+    bool open(const std::string& path);
+    void close();
+
+    size_t getFrameCnt() const { return index.size(); }
+    uint32_t getFrameSize() const { return header.frameSize; }
+    uint64_t getSimFrame(size_t k) const { return index[k].simFrame; }
+
+    // Decode k-th stored frame into out (getFrameSize() bytes).
+    bool readFrame(size_t k, void* out);
+
+private:
+    bool map(const std::string& path);
+    void unmap();
+    const SimFrameHeader* frameAt(size_t k) const;
+    bool readFrameHeader(uint64_t offset, uint64_t end, SimFrameHeader& fh) const;
+    bool checkIndex() const;
+
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mapHandle = nullptr;
+#else
+    int fd = -1;
+#endif
+    SimRecordHeader header;
+    std::vector<SimFrameIndex> index;
+    std::vector<uint8_t> cur;         // last decoded frame
+    size_t curK = SIZE_MAX;
+};
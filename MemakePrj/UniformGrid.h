@@ -0,0 +1,254 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+
+// Broad-phase uniform grid over the world.
+// Items are bucketed by their center, rebuilt with a counting sort.
+class UniformGrid
+{
+public:
+    void init(float worldW, float worldH, float cellSize)
+    {
+        this->cellSize = cellSize;
+        invCellSize = 1.f / cellSize;
+        cols = std::max(1, (int)(worldW * invCellSize) + 1);
+        rows = std::max(1, (int)(worldH * invCellSize) + 1);
+        cellStart.assign(cols * rows + 1, 0);
+    }
+
+    int getCols() const { return cols; }
+    int getRows() const { return rows; }
+    float getCellSize() const { return cellSize; }
+
+    int cellX(float x) const { return std::min(std::max((int)(x * invCellSize), 0), cols - 1); }
+    int cellY(float y) const { return std::min(std::max((int)(y * invCellSize), 0), rows - 1); }
+    int cellOf(float x, float y) const { return cellY(y) * cols + cellX(x); }
+
+    // getPos(i) returns Point2f of i-th item
+    template<typename GetPos>
+    void build(int cnt, GetPos getPos)
+    {
+        itemCell.resize(cnt);
+        items.resize(cnt);
+        std::fill(cellStart.begin(), cellStart.end(), 0);
+
+        for (int i = 0; i < cnt; ++i)
+        {
+            auto p = getPos(i);
+            itemCell[i] = cellOf(p.x, p.y);
+            cellStart[itemCell[i] + 1]++;
+        }
+        for (size_t c = 1; c < cellStart.size(); ++c)
+        {
+            cellStart[c] += cellStart[c - 1];
+        }
+        cellFill.assign(cellStart.begin(), cellStart.end() - 1);
+        for (int i = 0; i < cnt; ++i)
+        {
+            items[cellFill[itemCell[i]]++] = i;
+        }
+    }
+
+    // Call f(i) for every item whose cell overlaps the rectangle.
+    template<typename Func>
+    void forEachInRect(float x0, float y0, float x1, float y1, Func f) const
+    {
+        const int cx0 = cellX(x0);
+        const int cx1 = cellX(x1);
+        const int cy0 = cellY(y0);
+        const int cy1 = cellY(y1);
+        for (int cy = cy0; cy <= cy1; ++cy)
+        {
+            const int rowStart = cy * cols;
+            // cells of the row are contiguous in items
+            const int beg = cellStart[rowStart + cx0];
+            const int end = cellStart[rowStart + cx1 + 1];
+            for (int k = beg; k < end; ++k)
+            {
+                f(items[k]);
+            }
+        }
+    }
+
+private:
+    float cellSize = 1.f;
+    float invCellSize = 1.f;
+    int cols = 1;
+    int rows = 1;
+    std::vector<int> cellStart; // first item of each cell, one extra at the end
+    std::vector<int> cellFill;  // build scratch
+    std::vector<int> items;     // item ids sorted by cell
+    std::vector<int> itemCell;
+};
+
+// Uniform grid kept up to date between frames.
+// Every cell has k_cellSlots slots, items beyond that go to the cell's overflow list.
+// Overflow lists live in a pool and stay with their cell once made, so a cell whose
+// count goes back and forth across k_cellSlots doesn't allocate.
+// update() only touches items whose cell changed, which is cheap while items
+// move a fraction of a cell per step.
+class IncrementalGrid
+{
+public:
+    static const int k_cellSlots = 8;
+
+    void init(float worldW, float worldH, float cellSize)
+    {
+        this->cellSize = cellSize;
+        invCellSize = 1.f / cellSize;
+        cols = std::max(1, (int)(worldW * invCellSize) + 1);
+        rows = std::max(1, (int)(worldH * invCellSize) + 1);
+        cellCnt.assign(cols * rows, 0);
+        slots.assign(cols * rows * k_cellSlots, -1);
+        overflowList.assign(cols * rows, -1);
+        overflowLists.clear();
+        itemCell.clear();
+    }
+
+    int getCols() const { return cols; }
+    int getRows() const { return rows; }
+    float getCellSize() const { return cellSize; }
+    size_t getOverflowCellCnt() const
+    {
+        return std::count_if(overflowLists.begin(), overflowLists.end(), [](const std::vector<int>& list) { return !list.empty(); });
+    }
+
+    int cellX(float x) const { return std::min(std::max((int)(x * invCellSize), 0), cols - 1); }
+    int cellY(float y) const { return std::min(std::max((int)(y * invCellSize), 0), rows - 1); }
+    int cellOf(float x, float y) const { return cellY(y) * cols + cellX(x); }
+
+    // Move items whose cell changed, new items are inserted. Returns number of moved items.
+    template<typename GetPos>
+    int update(int cnt, GetPos getPos)
+    {
+        int moved = 0;
+        const int oldCnt = (int)itemCell.size();
+        for (int i = cnt; i < oldCnt; ++i)
+        {
+            remove(i, itemCell[i]);
+        }
+        itemCell.resize(cnt, -1);
+
+        for (int i = 0; i < cnt; ++i)
+        {
+            auto p = getPos(i);
+            const int cell = cellOf(p.x, p.y);
+            if (cell != itemCell[i])
+            {
+                if (itemCell[i] >= 0)
+                {
+                    remove(i, itemCell[i]);
+                }
+                insert(i, cell);
+                itemCell[i] = cell;
+                ++moved;
+            }
+        }
+        return moved;
+    }
+
+    // Call f(i) for every item whose cell overlaps the rectangle.
+    template<typename Func>
+    void forEachInRect(float x0, float y0, float x1, float y1, Func f) const
+    {
+        const int cx0 = cellX(x0);
+        const int cx1 = cellX(x1);
+        const int cy0 = cellY(y0);
+        const int cy1 = cellY(y1);
+        for (int cy = cy0; cy <= cy1; ++cy)
+        {
+            for (int cx = cx0; cx <= cx1; ++cx)
+            {
+                const int cell = cy * cols + cx;
+                const int cnt = cellCnt[cell];
+                const int inSlots = std::min(cnt, k_cellSlots);
+                const int* cellSlots = &slots[cell * k_cellSlots];
+                for (int k = 0; k < inSlots; ++k)
+                {
+                    f(cellSlots[k]);
+                }
+                if (cnt > k_cellSlots)
+                {
+                    for (int item : overflowLists[overflowList[cell]])
+                    {
+                        f(item);
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    void insert(int item, int cell)
+    {
+        int& cnt = cellCnt[cell];
+        if (cnt < k_cellSlots)
+        {
+            slots[cell * k_cellSlots + cnt] = item;
+        }
+        else
+        {
+            int& list = overflowList[cell];
+            if (list < 0)
+            {
+                list = (int)overflowLists.size();
+                overflowLists.emplace_back();
+            }
+            overflowLists[list].push_back(item);
+        }
+        ++cnt;
+    }
+
+    void remove(int item, int cell)
+    {
+        int& cnt = cellCnt[cell];
+        int* cellSlots = &slots[cell * k_cellSlots];
+        const int inSlots = std::min(cnt, k_cellSlots);
+        for (int k = 0; k < inSlots; ++k)
+        {
+            if (cellSlots[k] == item)
+            {
+                // refill the hole from overflow first, then from the last slot
+                if (cnt > k_cellSlots)
+                {
+                    std::vector<int>& list = overflowLists[overflowList[cell]];
+                    cellSlots[k] = list.back();
+                    list.pop_back();
+                }
+                else
+                {
+                    cellSlots[k] = cellSlots[cnt - 1];
+                    cellSlots[cnt - 1] = -1;
+                }
+                --cnt;
+                return;
+            }
+        }
+
+        if (cnt <= k_cellSlots)
+        {
+            return;
+        }
+        std::vector<int>& list = overflowLists[overflowList[cell]];
+        for (size_t k = 0; k < list.size(); ++k)
+        {
+            if (list[k] == item)
+            {
+                list[k] = list.back();
+                list.pop_back();
+                --cnt;
+                break;
+            }
+        }
+    }
+
+    float cellSize = 1.f;
+    float invCellSize = 1.f;
+    int cols = 1;
+    int rows = 1;
+    std::vector<int> cellCnt;                        // items in cell, slots and overflow together
+    std::vector<int> slots;                          // k_cellSlots item ids per cell
+    std::vector<int> overflowList;                   // index into overflowLists by cell, -1 until the cell first overflows
+    std::vector<std::vector<int>> overflowLists;     // items past k_cellSlots, emptied lists are kept
+    std::vector<int> itemCell;                       // current cell of every item
+};
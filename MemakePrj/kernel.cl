@@ -1,3 +1,24 @@
+// Values fixed for the whole run can be baked into the program at build
+// time with -D BALL_CNT=.. -D BL_CNT=.. -D WORLD_W=.. -D WORLD_H=.. so loops get
+// constant trip counts. Missing defines fall back to the kernel arguments.
+#ifndef BALL_CNT
+#define BALL_CNT ballCnt
+#endif
+
+#ifndef BL_CNT
+#define BL_CNT blCnt
+#else
+#define BL_CNT_IS_CONST
+#endif
+
+#ifndef WORLD_W
+#define WORLD_W worldW
+#endif
+
+#ifndef WORLD_H
+#define WORLD_H worldH
+#endif
+
 typedef struct Point2f
 {
     float x, y;
@@ -224,14 +245,14 @@ Ball checkCollisionBL(Ball b, BorderLine bl)
     return b;
 }
 
-Ball checkBorders(Ball b, const int scrW, const int scrH)
+Ball checkBorders(Ball b, const int worldW, const int worldH)
 {
     // check borders
     if ((b.pos.x - b.r) <= 0 && b.f.x < 0)
     {
         b.f.x = fabs(b.f.x);
     }
-    if ((b.pos.x + b.r) >= scrW && b.f.x > 0)
+    if ((b.pos.x + b.r) >= worldW && b.f.x > 0)
     {
         b.f.x = -fabs(b.f.x);
     }
@@ -239,7 +260,7 @@ Ball checkBorders(Ball b, const int scrW, const int scrH)
     {
         b.f.y = fabs(b.f.y);
     }
-    if ((b.pos.y + b.r) >= scrH && b.f.y > 0)
+    if ((b.pos.y + b.r) >= worldH && b.f.y > 0)
     {
         b.f.y = -fabs(b.f.y);
     }
@@ -252,14 +273,14 @@ __kernel void collideAndUpdate(
     const int ballCnt,
     __global BorderLine* bl,
     const int blCnt,
-    const int scrW,
-    const int scrH,
-    const double frameTimeMs)
+    const int worldW,
+    const int worldH,
+    const float frameTimeMs)
 {
     // Get work-item identifiers.
     int i = get_global_id(0);
     Ball ball = b1[i];
-    for (int j = 0; j < ballCnt; j++)
+    for (int j = 0; j < BALL_CNT; j++)
     {
         // check collision between one ball to others, but don't check collision to itself
         if (j != i)
@@ -268,12 +289,15 @@ __kernel void collideAndUpdate(
         }
     }
 
-    for (int j = 0; j < blCnt; ++j)
+#ifdef BL_CNT_IS_CONST
+    #pragma unroll
+#endif
+    for (int j = 0; j < BL_CNT; ++j)
     {
         ball = checkCollisionBL(ball, bl[j]);
     }
 
-    ball = checkBorders(ball, scrW, scrH);
+    ball = checkBorders(ball, WORLD_W, WORLD_H);
 
     // update positions
     ball.pos.x += ball.f.x * frameTimeMs;
@@ -1,397 +1,964 @@
-﻿#include "Memake/Memake.h"
-#ifdef GPU_VENDOR_IS_AMD
-#define CL_HPP_ENABLE_PROGRAM_CONSTRUCTION_FROM_ARRAY_COMPATIBILITY
-#include <CL/cl2.hpp>
-#endif // GPU_VENDOR_IS_AMD
-
-#ifdef GPU_VENDOR_IS_NVIDIA
-#include <CL/cl.hpp>
-#endif // GPU_VENDOR_IS_NVIDIA
-
-#include <math.h>
-#include <chrono>
-#include <vector>
-#include <fstream>
-#include <sstream>
-#include "mat2x2.h"
-
-using namespace std;
-
-Memake mmk(1024, 900, "memake");
-
-cl::Program program;  // The program that will run on the device.    
-cl::Context context;                // The context which holds the device.    
-cl::Device device;                  // The device where the kernel will run.
-
-// Return a device found in this OpenCL platform.
-cl::Device getDefaultDevice() {
-
-    // Search for all the OpenCL platforms available and check
-    // if there are any.
-    std::vector<cl::Platform> platforms;
-    cl::Platform::get(&platforms);
-
-    if (platforms.empty()) {
-        std::cerr << "No platforms found!" << std::endl;
-        exit(1);
-    }
-
-    // Search for all the devices on the first platform
-    // and check if there are any available.
-    auto platform = platforms.front();
-    std::vector<cl::Device> devices;
-    platform.getDevices(CL_DEVICE_TYPE_ALL, &devices);
-
-    if (devices.empty()) {
-        std::cerr << "No devices found!" << std::endl;
-        exit(1);
-    }
-
-    // Return the first device found.
-    return devices.front();
-}
-
-// Inicialize device and compile kernel code.
-void initializeDevice()
-{
-    // Select the first available device.
-    device = getDefaultDevice();
-
-    // Read OpenCL kernel file as a string.
-    context = cl::Context(device);
-    std::ifstream kernel_file("../../../kernel.cl");
-    std::string src(std::istreambuf_iterator<char>(kernel_file), (std::istreambuf_iterator<char>()));
-
-    // Compile kernel program which will run on the device.
-    cl::Program::Sources sources(1, std::make_pair(src.c_str(), src.length() + 1));
-    program = cl::Program(context, sources);
-    std::stringstream ss;
-    auto err = program.build(ss.str().c_str());
-    if (err != CL_BUILD_SUCCESS)
-    {
-        std::cerr << "Error!\nBuild Status: " << program.getBuildInfo<CL_PROGRAM_BUILD_STATUS>(device)
-            << "\nBuild Log:\t " << program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device) << std::endl;
-        exit(1);
-    }
-}
-
-struct BorderLine
-{
-public:
-    Point2f p1, p2;
-
-    void draw() const
-    {
-        mmk.drawLine(p1.x, p1.y, p2.x, p2.y, Colmake.white);
-    }
-
-    Point2f getXYMin() const
-    {
-        return { p1.x < p2.x ? p1.x : p2.x, p1.y < p2.y ? p1.y : p2.y };
-    }
-
-    Point2f getXYMax() const
-    {
-        return { p1.x > p2.x ? p1.x : p2.x, p1.y > p2.y ? p1.y : p2.y };
-    }
-};
-
-struct Ball 
-{
-public:
-    int id; // needs for debug purposes
-    float r;
-    Point2f pos;
-    Point2f f = { 0.f, 0.05f };
-
-    Ball(float _x = 0.f, float _y = 0.f, float _r = 0.f, float angle = 0.f, float _id = 0) 
-    {
-        pos.x = _x;
-        pos.y = _y;
-        r = _r;
-        f = Mat2x2f().rot(angle) * f;
-        id = _id;
-    }
-
-    void update(double frameTimeMs) 
-    {
-        move(frameTimeMs);
-    }
-
-    void draw() 
-    {
-        mmk.drawCircle(pos.x, pos.y, r, Colmake.beige);
-    }
-
-    void pulseColl(const Ball& b2)
-    {
-        // direction to other ball
-        Point2f toB2 = b2.pos - pos;
-        Point2f toB2Unit = toB2.unitVector();
-        // calculate dot product
-        float dotProdB = f.dotProduct(toB2Unit);
-        // calculate speed v for both balls
-        // that is projection to hit axis
-        float v1 = dotProdB;
-        float dotProdB2 = b2.f.dotProduct(toB2Unit);
-        float v2 = dotProdB2;
-        // if move projection to hit axis 
-        // for both balls are directed to move away 
-        // one from other then do nothing
-        if (v1 <= 0 && v2 >= 0)
-        {
-            return;
-        }
-        // mass is equal to square of 2d ball
-        float m1 = r * r;
-        float m2 = b2.r * b2.r;
-        // speed of this ball after collision 
-        float v1new = (2 * m2 * v2 + v1 * (m1 - m2)) / (m1 + m2);
-        // "to" move component
-        Point2f tmpTo = toB2Unit * v1new;
-        // "tangent" move component
-        Point2f tanUnit = Mat2x2f().rot(k_PI / 2) * toB2Unit;
-        float dotProdTan1 = f.dotProduct(tanUnit);
-        Point2f tmpTan = tanUnit * dotProdTan1;
-        // new move vector
-        Point2f newF = tmpTo + tmpTan;
-        f = newF;
-    }
-
-    void opticColl(const Ball& b)
-    {
-        // direction to other ball
-        Point2f toB = b.pos - pos;
-        // calculate dot product
-        float dotProd = f.dotProduct(toB);
-        // if dot product is negative then force directed away from B ball
-        // and we do nothing
-        if (dotProd > 0)
-        {
-            // angle between normal and force (moving) vectors
-            float angle = f.angleTo(toB);
-            // the angle of incidence is equal to the angle of reflection
-            f = Mat2x2f().rot(angle * 2) * f;
-            f = f * (-1.f);
-        }
-    }
-
-    void checkCollision(const Ball& b) 
-    {
-        float dist = pos.distanceTo(b.pos);
-        if (dist < r + b.r) 
-        {
-            pulseColl(b);
-        }
-    }
-
-    void opticCollPoint(const Point2f contactPoint)
-    {
-        // direction to other contact point
-        Point2f toContPoint = contactPoint - pos;
-        // calculate dot product
-        float dotProd = f.dotProduct(toContPoint);
-        // if dot product is negative then force directed away 
-        // from contact point and we do nothing
-        if (dotProd > 0)
-        {
-            // angle between normal and force (moving) vectors
-            float angle = f.angleTo(toContPoint);
-            // the angle of incidence is equal to the angle of reflection
-            f = Mat2x2f().rot(angle * 2) * f;
-            f = f * (-1.f);
-        }
-    }
-
-    void checkCollision(const BorderLine& bl)
-    {
-        // rectangle around line
-        Point2f xyMin = bl.getXYMin();
-        xyMin = {xyMin.x - r, xyMin.y - r};
-        Point2f xyMax = bl.getXYMax();
-        xyMax = { xyMax.x + r, xyMax.y + r };
-        if (pos.x >= xyMin.x && pos.y >= xyMin.y && pos.x <= xyMax.x && pos.y <= xyMax.y)
-        {
-            Point2f a = pos;
-            // sides of triangle
-            float p1a = bl.p1.distanceTo(a);
-            float p2a = bl.p2.distanceTo(a);
-            float p1p2 = bl.p1.distanceTo(bl.p2);
-            // angles
-            float ang1 = acos((p1a * p1a + p1p2 * p1p2 - p2a * p2a) / (2 * p1a * p1p2));
-            float ang2 = acos((p2a * p2a + p1p2 * p1p2 - p1a * p1a) / (2 * p2a * p1p2));
-            // if both angles are sharp then calculate h (distanse from a to line)
-            if (ang1 <= k_PI / 2 && ang2 <= k_PI / 2)
-            {
-                float h = sin(ang1) * p1a;
-                if (h <= r)
-                {
-                    // calculate contact point
-                    float cath1 = cos(ang1) * p1a;
-                    Point2f v = (bl.p2 - bl.p1).unitVector() * cath1;
-                    Point2f contactPoint = bl.p1 + v;
-                    opticCollPoint(contactPoint);
-                }
-            }
-            else if (p1a <= r) // first line end
-            {
-                opticCollPoint(bl.p1);
-            }
-            else if (p2a <= r) // second line end
-            {
-                opticCollPoint(bl.p2);
-            }
-        }
-    }
-
-    void move(double frameTimeMs)
-    {
-        pos.x += f.x * frameTimeMs;
-        pos.y += f.y * frameTimeMs;
-    }
-
-    void checkBorders() 
-    {
-        if ((pos.x - r) <= 0 && f.x < 0)
-        {
-            f.x = abs(f.x);
-        }
-        if ((pos.x + r) >= mmk.getScreenW() && f.x > 0)
-        {
-            f.x = -abs(f.x);
-        }
-        if ((pos.y - r) <= 0 && f.y < 0) 
-        {
-            f.y = abs(f.y);
-        }
-        if ((pos.y + r) >= mmk.getScreenH() && f.y > 0)
-        {
-            f.y = -abs(f.y);
-        }
-    }
-
-};
-
-void colladeAndUpdateCPU(Ball* b, Ball* tmpB, const int numOfBall, BorderLine* bordLine, const int bordLineCnt, const double frameTimeMs)
-{
-    for (int i = 0; i < numOfBall; i++)
-    {
-        Ball ball = b[i];
-        for (int j = 0; j < numOfBall; j++)
-        {
-            // check collision between one ball to others, but don't check collision to itself
-            if (j != i)
-            {
-                ball.checkCollision(b[j]);
-            }
-        }
-
-        for (int j = 0; j < bordLineCnt; ++j)
-        {
-            ball.checkCollision(bordLine[j]);
-        }
-
-        ball.checkBorders();
-        ball.update(frameTimeMs);  // update/move every ball
-        tmpB[i] = ball;
-    }
-}
-
-void colladeAndUpdateGPU(Ball* b, Ball* tmpB, const int numOfBall, BorderLine* bl, int blCnt, const double frameTimeMs)
-{
-    cl::Buffer inB(context, CL_MEM_READ_WRITE | CL_MEM_HOST_READ_ONLY | CL_MEM_COPY_HOST_PTR, numOfBall * sizeof(Ball), (void*)b);
-    cl::Buffer outB(context, CL_MEM_READ_WRITE | CL_MEM_HOST_READ_ONLY | CL_MEM_COPY_HOST_PTR, numOfBall * sizeof(Ball), (void*)tmpB);
-    cl::Buffer inBl(context, CL_MEM_READ_WRITE | CL_MEM_HOST_READ_ONLY | CL_MEM_COPY_HOST_PTR, blCnt * sizeof(BorderLine), (void*)bl);
-
-    cl::Kernel kern(program, "collideAndUpdate");
-    kern.setArg(0, inB);
-    kern.setArg(1, outB);
-    kern.setArg(2, numOfBall);
-    kern.setArg(3, inBl);
-    kern.setArg(4, blCnt);
-    kern.setArg(5, mmk.getScreenW());
-    kern.setArg(6, mmk.getScreenH());
-    kern.setArg(7, frameTimeMs);
-
-    cl::CommandQueue queue(context, device);
-    queue.enqueueNDRangeKernel(kern, cl::NullRange, cl::NDRange(numOfBall, 1));
-    queue.enqueueReadBuffer(outB, CL_TRUE, 0, numOfBall * sizeof(Ball), tmpB);
-}
-
-int main()
-{
-    const int numOfBall = 4000;
-    vector<Ball> b1;
-    b1.reserve(numOfBall);
-    int sW = mmk.getScreenW();
-    int sH = mmk.getScreenH();
-    float r = 3;
-    float d = 2 * r;
-    int col = 0;
-    int row = 0;
-    for (int i = 0; i < numOfBall; i++)
-    {
-        int x = col * 1.5 * d + 0.75 * d;
-        int y = row * 1.5 * d + 0.75 * d;
-        b1.push_back(Ball(x, y, r, random_f(0.f, k_PI * 2.f), i));
-        if ((x + 1.5 * d) > sW)
-        {
-            col = 0;
-            row++;
-        }
-        else
-        {
-            col++;
-        }
-    }
-
-    std::vector<BorderLine> lines;
-    lines.push_back({ {0, 400}, {300, 500} });
-    lines.push_back({ {300, 500}, {400, 600} });
-    lines.push_back({ {400, 600}, {450, 700} });
-    lines.push_back({ {1023, 400}, {723, 500} });
-    lines.push_back({ {723, 500}, {623, 600} });
-    lines.push_back({ {623, 600}, {573, 700} });
-
-    // Initialize OpenCL device.
-    initializeDevice();
-
-    long long frameCnt = 0;
-    auto t_start = std::chrono::high_resolution_clock::now();
-    auto curTime = t_start;
-    double frameTimeMs = 0;
-    vector<Ball> b2(numOfBall);
-    Ball* b = &b1[0];
-    Ball* tmpB = &b2[0];
-    BorderLine* bLine = &lines[0];
-    mmk.update( [&]() 
-    {
-        colladeAndUpdateGPU(b, tmpB, numOfBall, bLine, lines.size(), frameTimeMs);
-
-        for (int i = 0; i < numOfBall; ++i)
-        {
-            tmpB[i].draw();
-        }
-
-        for (int i = 0; i < lines.size(); ++i)
-        {
-            bLine[i].draw();
-        }
-
-        swap(b, tmpB);
-        
-        auto oldTime = curTime;
-        curTime = std::chrono::high_resolution_clock::now();
-        frameTimeMs = std::chrono::duration<double, std::milli>(curTime - oldTime).count();
-
-        frameCnt++;
-        //mmk.delay(100);
-    });
-
-    auto t_end = std::chrono::high_resolution_clock::now();
-    auto timeMs = std::chrono::duration<double, std::milli>(t_end - t_start).count();
-    auto fps = frameCnt * 1000 / timeMs;
-    std::cout << "fps: " << fps << std::endl;
-
-    return 0;
+﻿#include "Memake/Memake.h"
+#ifdef GPU_VENDOR_IS_AMD
+#define CL_HPP_ENABLE_PROGRAM_CONSTRUCTION_FROM_ARRAY_COMPATIBILITY
+#include <CL/cl2.hpp>
+#endif // GPU_VENDOR_IS_AMD
+
+#ifdef GPU_VENDOR_IS_NVIDIA
+#include <CL/cl.hpp>
+#endif // GPU_VENDOR_IS_NVIDIA
+
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <tuple>
+#include <algorithm>
+#include <memory>
+#include <iomanip>
+#include "mat2x2.h"
+#include "SimRecord.h"
+#include "UniformGrid.h"
+#include "BallRaster.h"
+#include "ClRaster.h"
+
+using namespace std;
+
+const int k_screenW = 1024;
+const int k_screenH = 900;
+
+// Created in main, windowed or offscreen.
+std::unique_ptr<Memake> mmk;
+
+// Simulation area, independent of the window size.
+int worldW = k_screenW;
+int worldH = k_screenH;
+
+// View into the world: top-left corner in world coordinates and zoom.
+struct Camera
+{
+    float x = 0.f;
+    float y = 0.f;
+    float zoom = 1.f;
+
+    Point2f toScreen(const Point2f& p) const
+    {
+        return { (p.x - x) * zoom, (p.y - y) * zoom };
+    }
+
+    // visible world rectangle
+    Point2f getXYMin() const
+    {
+        return { x, y };
+    }
+
+    Point2f getXYMax() const
+    {
+        return { x + mmk->getScreenW() / zoom, y + mmk->getScreenH() / zoom };
+    }
+
+    // arrows pan, +/- zoom around screen center
+    void update(float dt)
+    {
+        const float panSpeed = 600.f / zoom;
+        if (mmk->isKeyDown(SDLK_LEFT))  x -= panSpeed * dt;
+        if (mmk->isKeyDown(SDLK_RIGHT)) x += panSpeed * dt;
+        if (mmk->isKeyDown(SDLK_UP))    y -= panSpeed * dt;
+        if (mmk->isKeyDown(SDLK_DOWN))  y += panSpeed * dt;
+
+        float newZoom = zoom;
+        if (mmk->isKeyDown(SDLK_EQUALS) || mmk->isKeyDown(SDLK_KP_PLUS))  newZoom *= 1.f + 2.f * dt;
+        if (mmk->isKeyDown(SDLK_MINUS) || mmk->isKeyDown(SDLK_KP_MINUS)) newZoom /= 1.f + 2.f * dt;
+        newZoom = std::min(std::max(newZoom, 0.02f), 16.f);
+        if (newZoom != zoom)
+        {
+            const float cx = x + mmk->getScreenW() * 0.5f / zoom;
+            const float cy = y + mmk->getScreenH() * 0.5f / zoom;
+            zoom = newZoom;
+            x = cx - mmk->getScreenW() * 0.5f / zoom;
+            y = cy - mmk->getScreenH() * 0.5f / zoom;
+        }
+    }
+};
+
+Camera camera;
+
+// Broad-phase grid cell side in world units.
+const float k_gridCellSize = 64.f;
+
+cl::Context context;                // The context which holds the device.    
+cl::Device device;                  // The device where the kernel will run.
+std::string kernelSrc;              // Source of kernel.cl, compiled once per variant.
+
+// Values baked into a program variant as build-time constants.
+// A zero field is not baked and is taken from the kernel argument instead.
+struct KernelVariantKey
+{
+    int ballCnt = 0;
+    int blCnt = 0;
+    int worldW = 0;
+    int worldH = 0;
+
+    bool operator<(const KernelVariantKey& k) const
+    {
+        return std::tie(ballCnt, blCnt, worldW, worldH) < std::tie(k.ballCnt, k.blCnt, k.worldW, k.worldH);
+    }
+};
+
+std::map<KernelVariantKey, cl::Program> programVariants; // Programs built so far.
+cl::Kernel collideKernel;           // collideAndUpdate of the variant picked at setup.
+
+// Return a device of the type, CL_DEVICE_TYPE_ALL takes the first platform's
+// first device, other types are searched for on all platforms.
+cl::Device getDefaultDevice(cl_device_type type) {
+
+    // Search for all the OpenCL platforms available and check
+    // if there are any.
+    std::vector<cl::Platform> platforms;
+    cl::Platform::get(&platforms);
+
+    if (platforms.empty()) {
+        std::cerr << "No platforms found!" << std::endl;
+        exit(1);
+    }
+
+    // Search for all the devices on the first platform, or the first
+    // platform having the requested type, and check if there are any.
+    std::vector<cl::Device> devices;
+    for (auto& platform : platforms) {
+        platform.getDevices(type, &devices);
+        if (!devices.empty() || type == CL_DEVICE_TYPE_ALL) {
+            break;
+        }
+    }
+
+    if (devices.empty()) {
+        std::cerr << "No devices found!" << std::endl;
+        exit(1);
+    }
+
+    // Return the first device found.
+    return devices.front();
+}
+
+// Inicialize device and read kernel code, once for the simulation and the rasterizer.
+void initializeDevice(cl_device_type type)
+{
+    if (!kernelSrc.empty())
+    {
+        return;
+    }
+
+    // Select the first available device.
+    device = getDefaultDevice(type);
+
+    // Read OpenCL kernel file as a string.
+    context = cl::Context(device);
+    std::ifstream kernel_file("../../../kernel.cl");
+    kernelSrc = std::string(std::istreambuf_iterator<char>(kernel_file), (std::istreambuf_iterator<char>()));
+}
+
+// Return program compiled with the key's constants, building it on first request.
+cl::Program& getProgramVariant(const KernelVariantKey& key)
+{
+    auto it = programVariants.find(key);
+    if (it != programVariants.end())
+    {
+        return it->second;
+    }
+
+    // only float math is used, so keep unsuffixed literals single precision too
+    std::stringstream ss;
+    ss << "-cl-single-precision-constant";
+    if (key.ballCnt > 0) ss << " -D BALL_CNT=" << key.ballCnt;
+    if (key.blCnt > 0)   ss << " -D BL_CNT=" << key.blCnt;
+    if (key.worldW > 0)  ss << " -D WORLD_W=" << key.worldW;
+    if (key.worldH > 0)  ss << " -D WORLD_H=" << key.worldH;
+
+    // Compile kernel program which will run on the device.
+    cl::Program::Sources sources(1, std::make_pair(kernelSrc.c_str(), kernelSrc.length() + 1));
+    cl::Program program(context, sources);
+    auto err = program.build(ss.str().c_str());
+    if (err != CL_BUILD_SUCCESS)
+    {
+        std::cerr << "Error!\nBuild Status: " << program.getBuildInfo<CL_PROGRAM_BUILD_STATUS>(device)
+            << "\nBuild Log:\t " << program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device) << std::endl;
+        exit(1);
+    }
+    return programVariants[key] = program;
+}
+
+// Pick collideAndUpdate specialized for values fixed across the run.
+void selectKernelVariant(const KernelVariantKey& key)
+{
+    collideKernel = cl::Kernel(getProgramVariant(key), "collideAndUpdate");
+}
+
+struct BorderLine
+{
+public:
+    Point2f p1, p2;
+
+    void draw(const Camera& cam) const
+    {
+        Point2f s1 = cam.toScreen(p1);
+        Point2f s2 = cam.toScreen(p2);
+        mmk->drawLine(s1.x, s1.y, s2.x, s2.y, Colmake.white);
+    }
+
+    Point2f getXYMin() const
+    {
+        return { p1.x < p2.x ? p1.x : p2.x, p1.y < p2.y ? p1.y : p2.y };
+    }
+
+    Point2f getXYMax() const
+    {
+        return { p1.x > p2.x ? p1.x : p2.x, p1.y > p2.y ? p1.y : p2.y };
+    }
+};
+
+struct Ball 
+{
+public:
+    int id; // needs for debug purposes
+    float r;
+    Point2f pos;
+    Point2f f = { 0.f, 0.05f };
+
+    Ball(float _x = 0.f, float _y = 0.f, float _r = 0.f, float angle = 0.f, float _id = 0) 
+    {
+        pos.x = _x;
+        pos.y = _y;
+        r = _r;
+        f = Mat2x2f().rot(angle) * f;
+        id = _id;
+    }
+
+    void update(double frameTimeMs) 
+    {
+        move(frameTimeMs);
+    }
+
+    void draw(const Camera& cam) const
+    {
+        Point2f s = cam.toScreen(pos);
+        mmk->drawCircle(s.x, s.y, r * cam.zoom, Colmake.beige);
+    }
+
+    void pulseColl(const Ball& b2)
+    {
+        // direction to other ball
+        Point2f toB2 = b2.pos - pos;
+        Point2f toB2Unit = toB2.unitVector();
+        // calculate dot product
+        float dotProdB = f.dotProduct(toB2Unit);
+        // calculate speed v for both balls
+        // that is projection to hit axis
+        float v1 = dotProdB;
+        float dotProdB2 = b2.f.dotProduct(toB2Unit);
+        float v2 = dotProdB2;
+        // if move projection to hit axis 
+        // for both balls are directed to move away 
+        // one from other then do nothing
+        if (v1 <= 0 && v2 >= 0)
+        {
+            return;
+        }
+        // mass is equal to square of 2d ball
+        float m1 = r * r;
+        float m2 = b2.r * b2.r;
+        // speed of this ball after collision 
+        float v1new = (2 * m2 * v2 + v1 * (m1 - m2)) / (m1 + m2);
+        // "to" move component
+        Point2f tmpTo = toB2Unit * v1new;
+        // "tangent" move component
+        Point2f tanUnit = Mat2x2f().rot(k_PI / 2) * toB2Unit;
+        float dotProdTan1 = f.dotProduct(tanUnit);
+        Point2f tmpTan = tanUnit * dotProdTan1;
+        // new move vector
+        Point2f newF = tmpTo + tmpTan;
+        f = newF;
+    }
+
+    void opticColl(const Ball& b)
+    {
+        // direction to other ball
+        Point2f toB = b.pos - pos;
+        // calculate dot product
+        float dotProd = f.dotProduct(toB);
+        // if dot product is negative then force directed away from B ball
+        // and we do nothing
+        if (dotProd > 0)
+        {
+            // angle between normal and force (moving) vectors
+            float angle = f.angleTo(toB);
+            // the angle of incidence is equal to the angle of reflection
+            f = Mat2x2f().rot(angle * 2) * f;
+            f = f * (-1.f);
+        }
+    }
+
+    void checkCollision(const Ball& b) 
+    {
+        float dist = pos.distanceTo(b.pos);
+        if (dist < r + b.r) 
+        {
+            pulseColl(b);
+        }
+    }
+
+    void opticCollPoint(const Point2f contactPoint)
+    {
+        // direction to other contact point
+        Point2f toContPoint = contactPoint - pos;
+        // calculate dot product
+        float dotProd = f.dotProduct(toContPoint);
+        // if dot product is negative then force directed away 
+        // from contact point and we do nothing
+        if (dotProd > 0)
+        {
+            // angle between normal and force (moving) vectors
+            float angle = f.angleTo(toContPoint);
+            // the angle of incidence is equal to the angle of reflection
+            f = Mat2x2f().rot(angle * 2) * f;
+            f = f * (-1.f);
+        }
+    }
+
+    void checkCollision(const BorderLine& bl)
+    {
+        // rectangle around line
+        Point2f xyMin = bl.getXYMin();
+        xyMin = {xyMin.x - r, xyMin.y - r};
+        Point2f xyMax = bl.getXYMax();
+        xyMax = { xyMax.x + r, xyMax.y + r };
+        if (pos.x >= xyMin.x && pos.y >= xyMin.y && pos.x <= xyMax.x && pos.y <= xyMax.y)
+        {
+            Point2f a = pos;
+            // sides of triangle
+            float p1a = bl.p1.distanceTo(a);
+            float p2a = bl.p2.distanceTo(a);
+            float p1p2 = bl.p1.distanceTo(bl.p2);
+            // angles
+            float ang1 = acos((p1a * p1a + p1p2 * p1p2 - p2a * p2a) / (2 * p1a * p1p2));
+            float ang2 = acos((p2a * p2a + p1p2 * p1p2 - p1a * p1a) / (2 * p2a * p1p2));
+            // if both angles are sharp then calculate h (distanse from a to line)
+            if (ang1 <= k_PI / 2 && ang2 <= k_PI / 2)
+            {
+                float h = sin(ang1) * p1a;
+                if (h <= r)
+                {
+                    // calculate contact point
+                    float cath1 = cos(ang1) * p1a;
+                    Point2f v = (bl.p2 - bl.p1).unitVector() * cath1;
+                    Point2f contactPoint = bl.p1 + v;
+                    opticCollPoint(contactPoint);
+                }
+            }
+            else if (p1a <= r) // first line end
+            {
+                opticCollPoint(bl.p1);
+            }
+            else if (p2a <= r) // second line end
+            {
+                opticCollPoint(bl.p2);
+            }
+        }
+    }
+
+    void move(double frameTimeMs)
+    {
+        pos.x += f.x * frameTimeMs;
+        pos.y += f.y * frameTimeMs;
+    }
+
+    void checkBorders() 
+    {
+        if ((pos.x - r) <= 0 && f.x < 0)
+        {
+            f.x = abs(f.x);
+        }
+        if ((pos.x + r) >= worldW && f.x > 0)
+        {
+            f.x = -abs(f.x);
+        }
+        if ((pos.y - r) <= 0 && f.y < 0) 
+        {
+            f.y = abs(f.y);
+        }
+        if ((pos.y + r) >= worldH && f.y > 0)
+        {
+            f.y = -abs(f.y);
+        }
+    }
+
+};
+
+void colladeAndUpdateCPU(Ball* b, Ball* tmpB, const int numOfBall, BorderLine* bordLine, const int bordLineCnt, const double frameTimeMs)
+{
+    for (int i = 0; i < numOfBall; i++)
+    {
+        Ball ball = b[i];
+        for (int j = 0; j < numOfBall; j++)
+        {
+            // check collision between one ball to others, but don't check collision to itself
+            if (j != i)
+            {
+                ball.checkCollision(b[j]);
+            }
+        }
+
+        for (int j = 0; j < bordLineCnt; ++j)
+        {
+            ball.checkCollision(bordLine[j]);
+        }
+
+        ball.checkBorders();
+        ball.update(frameTimeMs);  // update/move every ball
+        tmpB[i] = ball;
+    }
+}
+
+// Same as colladeAndUpdateCPU, but only balls from cells within reach are checked.
+template<typename Grid>
+void colladeAndUpdateCPUGrid(Ball* b, Ball* tmpB, const int numOfBall, const float maxR, BorderLine* bordLine, const int bordLineCnt, const Grid& grid, const double frameTimeMs)
+{
+    for (int i = 0; i < numOfBall; i++)
+    {
+        Ball ball = b[i];
+        const float reach = ball.r + maxR;
+        grid.forEachInRect(ball.pos.x - reach, ball.pos.y - reach, ball.pos.x + reach, ball.pos.y + reach, [&](int j)
+        {
+            // check collision between one ball to others, but don't check collision to itself
+            if (j != i)
+            {
+                ball.checkCollision(b[j]);
+            }
+        });
+
+        for (int j = 0; j < bordLineCnt; ++j)
+        {
+            ball.checkCollision(bordLine[j]);
+        }
+
+        ball.checkBorders();
+        ball.update(frameTimeMs);  // update/move every ball
+        tmpB[i] = ball;
+    }
+}
+
+void colladeAndUpdateGPU(Ball* b, Ball* tmpB, const int numOfBall, BorderLine* bl, int blCnt, const float frameTimeMs)
+{
+    cl::Buffer inB(context, CL_MEM_READ_WRITE | CL_MEM_HOST_READ_ONLY | CL_MEM_COPY_HOST_PTR, numOfBall * sizeof(Ball), (void*)b);
+    cl::Buffer outB(context, CL_MEM_READ_WRITE | CL_MEM_HOST_READ_ONLY | CL_MEM_COPY_HOST_PTR, numOfBall * sizeof(Ball), (void*)tmpB);
+    cl::Buffer inBl(context, CL_MEM_READ_WRITE | CL_MEM_HOST_READ_ONLY | CL_MEM_COPY_HOST_PTR, blCnt * sizeof(BorderLine), (void*)bl);
+
+    cl::Kernel& kern = collideKernel;
+    kern.setArg(0, inB);
+    kern.setArg(1, outB);
+    kern.setArg(2, numOfBall);
+    kern.setArg(3, inBl);
+    kern.setArg(4, blCnt);
+    kern.setArg(5, worldW);
+    kern.setArg(6, worldH);
+    kern.setArg(7, frameTimeMs);
+
+    cl::CommandQueue queue(context, device);
+    queue.enqueueNDRangeKernel(kern, cl::NullRange, cl::NDRange(numOfBall, 1));
+    queue.enqueueReadBuffer(outB, CL_TRUE, 0, numOfBall * sizeof(Ball), tmpB);
+}
+
+// Draw balls and lines intersecting the camera rectangle, balls are looked up in the grid.
+// Balls go through the CPU rasterizer when it's given, otherwise through SDL renderer calls.
+template<typename Grid>
+void drawVisible(const Ball* b, const int numOfBall, const float maxR, const BorderLine* bl, const int blCnt, const Grid& grid, BallRaster* raster)
+{
+    if (raster)
+    {
+        raster->begin(mmk->getScreenW(), mmk->getScreenH());
+    }
+
+    const Point2f vMin = camera.getXYMin();
+    const Point2f vMax = camera.getXYMax();
+    const Uint32 ballColor = packARGB(Colmake.beige);
+    // visible balls in screen space, drawn with one call
+    static vector<float> xs, ys, rs;
+    static vector<Color> colors;
+    xs.clear();
+    ys.clear();
+    rs.clear();
+    // balls are bucketed by center, so widen the view by the biggest radius
+    grid.forEachInRect(vMin.x - maxR, vMin.y - maxR, vMax.x + maxR, vMax.y + maxR, [&](int i)
+    {
+        const Ball& ball = b[i];
+        if (ball.pos.x + ball.r >= vMin.x && ball.pos.x - ball.r <= vMax.x &&
+            ball.pos.y + ball.r >= vMin.y && ball.pos.y - ball.r <= vMax.y)
+        {
+            Point2f s = camera.toScreen(ball.pos);
+            if (raster)
+            {
+                raster->addCircle(s.x, s.y, ball.r * camera.zoom, ballColor);
+            }
+            else
+            {
+                xs.push_back(s.x);
+                ys.push_back(s.y);
+                rs.push_back(ball.r * camera.zoom);
+            }
+        }
+    });
+    if (!xs.empty())
+    {
+        colors.resize(xs.size(), Colmake.beige);
+        mmk->drawCircles(xs.data(), ys.data(), rs.data(), colors.data(), xs.size());
+    }
+
+    if (raster)
+    {
+        int pitch = 0;
+        Uint32* pixels = mmk->lockFramebuffer(pitch);
+        if (pixels)
+        {
+            raster->render(pixels, pitch, packARGB(Colmake.black));
+            mmk->unlockFramebuffer();
+        }
+    }
+
+    // lines are static in the world, draw them again only when the camera moved
+    static Camera borderCam = { -1.f, -1.f, 0.f };
+    if (borderCam.x != camera.x || borderCam.y != camera.y || borderCam.zoom != camera.zoom)
+    {
+        borderCam = camera;
+        mmk->invalidateLayer("borders");
+    }
+    if (blCnt > 0 && mmk->beginLayer("borders"))
+    {
+        for (int i = 0; i < blCnt; ++i)
+        {
+            const Point2f lMin = bl[i].getXYMin();
+            const Point2f lMax = bl[i].getXYMax();
+            if (lMax.x >= vMin.x && lMin.x <= vMax.x && lMax.y >= vMin.y && lMin.y <= vMax.y)
+            {
+                bl[i].draw(camera);
+            }
+        }
+        mmk->endLayer();
+    }
+}
+
+float getMaxRadius(const Ball* b, const int numOfBall)
+{
+    float maxR = 0.f;
+    for (int i = 0; i < numOfBall; ++i)
+    {
+        maxR = std::max(maxR, b[i].r);
+    }
+    return maxR;
+}
+
+// Draw recorded run frame by frame, no simulation is done.
+int replay(const std::string& path, BallRaster* raster)
+{
+    SimReplay rp;
+    if (!rp.open(path) || rp.getFrameCnt() == 0 || rp.getFrameSize() % sizeof(Ball) != 0)
+    {
+        std::cerr << "Can't replay " << path << std::endl;
+        return 1;
+    }
+
+    vector<Ball> b(rp.getFrameSize() / sizeof(Ball));
+    if (!rp.readFrame(0, &b[0]))
+    {
+        std::cerr << "Can't replay " << path << std::endl;
+        return 1;
+    }
+    const float maxR = getMaxRadius(&b[0], b.size());
+    UniformGrid grid;
+    grid.init(worldW, worldH, k_gridCellSize);
+    size_t k = 0;
+    bool reportedBad = false;
+    mmk->update([&]()
+    {
+        camera.update(mmk->getDeltaTime());
+        // a corrupt frame leaves b untouched, the last good frame stays on screen
+        if (rp.readFrame(k, &b[0]))
+        {
+            grid.build(b.size(), [&b](int i) { return b[i].pos; });
+        }
+        else if (!reportedBad)
+        {
+            std::cerr << "Skipping corrupt frames of " << path << ", first at " << k << std::endl;
+            reportedBad = true;
+        }
+        drawVisible(&b[0], b.size(), maxR, nullptr, 0, grid, raster);
+        k = (k + 1) % rp.getFrameCnt();
+    });
+    return 0;
+}
+
+// Time full grid rebuild against incremental update for several ball counts
+// and step lengths, step is given as a fraction of the cell size.
+void benchGrid()
+{
+    const float cellSize = 12.f;
+    const int stepCnt = 100;
+    std::cout << std::setw(8) << "balls" << std::setw(12) << "step/cell" << std::setw(14) << "rebuild ms"
+        << std::setw(18) << "incremental ms" << std::setw(10) << "moved %" << std::endl;
+
+    for (int cnt : { 1000, 4000, 16000, 64000 })
+    {
+        for (float stepFrac : { 0.01f, 0.05f, 0.1f, 0.25f, 0.5f, 1.f })
+        {
+            vector<Point2f> pos(cnt);
+            vector<Point2f> vel(cnt);
+            for (int i = 0; i < cnt; ++i)
+            {
+                pos[i] = { random_f(0.f, (float)worldW), random_f(0.f, (float)worldH) };
+                vel[i] = Mat2x2f().rot(random_f(0.f, k_PI * 2.f)) * Point2f{ stepFrac * cellSize, 0.f };
+            }
+
+            UniformGrid full;
+            full.init(worldW, worldH, cellSize);
+            IncrementalGrid incr;
+            incr.init(worldW, worldH, cellSize);
+            auto getPos = [&pos](int i) { return pos[i]; };
+            incr.update(cnt, getPos);
+
+            double rebuildMs = 0;
+            double incrMs = 0;
+            long long moved = 0;
+            for (int step = 0; step < stepCnt; ++step)
+            {
+                for (int i = 0; i < cnt; ++i)
+                {
+                    pos[i] += vel[i];
+                    if (pos[i].x < 0 || pos[i].x >= worldW) { vel[i].x = -vel[i].x; pos[i].x += 2 * vel[i].x; }
+                    if (pos[i].y < 0 || pos[i].y >= worldH) { vel[i].y = -vel[i].y; pos[i].y += 2 * vel[i].y; }
+                }
+
+                auto t0 = std::chrono::high_resolution_clock::now();
+                full.build(cnt, getPos);
+                auto t1 = std::chrono::high_resolution_clock::now();
+                moved += incr.update(cnt, getPos);
+                auto t2 = std::chrono::high_resolution_clock::now();
+
+                rebuildMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+                incrMs += std::chrono::duration<double, std::milli>(t2 - t1).count();
+            }
+
+            std::cout << std::setw(8) << cnt << std::setw(12) << stepFrac
+                << std::setw(14) << rebuildMs / stepCnt << std::setw(18) << incrMs / stepCnt
+                << std::setw(10) << 100.0 * moved / ((double)cnt * stepCnt) << std::endl;
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    // --record <file>     : stream ball states to file
+    // --record-step <N>   : store every Nth frame only
+    // --record-delta      : delta encode frames between key frames
+    // --replay <file>     : draw recorded file instead of simulating
+    // --world-scale <N>   : world is N times wider and higher than the window
+    // --soft-raster       : draw balls with threaded CPU rasterizer
+    // --cpu               : simulate on CPU with incrementally updated collision grid
+    // --bench-grid        : compare grid rebuild with incremental update and exit
+    // --offscreen <N>     : render N frames without window and print draw times
+    // --dump <prefix>     : with --offscreen, save frames as <prefix>00000.bmp, ...
+    // --workers <N>       : with --offscreen, threads of the tiled CPU rasterizer, e.g. to measure its scaling
+    // --vsync             : pace frames with display refresh
+    // --fps <N>           : pace frames with timer at N fps
+    // --renderer <name>   : SDL render driver, e.g. opengl, direct3d11, software
+    // --render-thread     : render on its own thread while the next frame is simulated
+    // --tile-raster       : draw everything with Memake's tiled CPU rasterizer
+    // --cl-raster         : draw everything with the OpenCL rasterizer (raster.cl)
+    // --cl-cpu            : run OpenCL on a CPU device, e.g. to test without a GPU
+    // --stats             : show frame time graph
+    // --stats-log <file>  : write frame statistics averaged over 60 frames as CSV
+    // --capture <prefix>  : save frames as <prefix>00000.bmp, ... from a background thread, dropped if it falls behind
+    // --capture-raw       : with --capture, write headerless ARGB8888 .raw files instead of BMP
+    std::string recordPath;
+    std::string replayPath;
+    unsigned int recordStep = 1;
+    bool recordDelta = false;
+    bool softRaster = false;
+    bool cpuSim = false;
+    int offscreenFrames = 0;
+    std::string dumpPrefix;
+    unsigned int workerCnt = 0;
+    WindowOptions windowOptions;
+    bool renderThread = false;
+    bool tileRaster = false;
+    bool clRaster = false;
+    cl_device_type deviceType = CL_DEVICE_TYPE_ALL;
+    bool statsOverlay = false;
+    std::string statsLogPath;
+    std::string capturePrefix;
+    FrameCapture::Format captureFormat = FrameCapture::Format::Bmp;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--record" && i + 1 < argc)
+        {
+            recordPath = argv[++i];
+        }
+        else if (arg == "--record-step" && i + 1 < argc)
+        {
+            recordStep = std::stoul(argv[++i]);
+        }
+        else if (arg == "--record-delta")
+        {
+            recordDelta = true;
+        }
+        else if (arg == "--world-scale" && i + 1 < argc)
+        {
+            const int scale = std::max(1, std::stoi(argv[++i]));
+            worldW = k_screenW * scale;
+            worldH = k_screenH * scale;
+        }
+        else if (arg == "--soft-raster")
+        {
+            softRaster = true;
+        }
+        else if (arg == "--cpu")
+        {
+            cpuSim = true;
+        }
+        else if (arg == "--bench-grid")
+        {
+            benchGrid();
+            return 0;
+        }
+        else if (arg == "--replay" && i + 1 < argc)
+        {
+            replayPath = argv[++i];
+        }
+        else if (arg == "--offscreen" && i + 1 < argc)
+        {
+            offscreenFrames = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--dump" && i + 1 < argc)
+        {
+            dumpPrefix = argv[++i];
+        }
+        else if (arg == "--workers" && i + 1 < argc)
+        {
+            workerCnt = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--vsync")
+        {
+            windowOptions.pacing = FramePacing::VSync;
+        }
+        else if (arg == "--fps" && i + 1 < argc)
+        {
+            windowOptions.pacing = FramePacing::FixedFps;
+            windowOptions.targetFps = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--renderer" && i + 1 < argc)
+        {
+            windowOptions.renderDriver = argv[++i];
+        }
+        else if (arg == "--render-thread")
+        {
+            renderThread = true;
+        }
+        else if (arg == "--tile-raster")
+        {
+            tileRaster = true;
+        }
+        else if (arg == "--cl-raster")
+        {
+            clRaster = true;
+        }
+        else if (arg == "--cl-cpu")
+        {
+            deviceType = CL_DEVICE_TYPE_CPU;
+        }
+        else if (arg == "--stats")
+        {
+            statsOverlay = true;
+        }
+        else if (arg == "--stats-log" && i + 1 < argc)
+        {
+            statsLogPath = argv[++i];
+        }
+        else if (arg == "--capture" && i + 1 < argc)
+        {
+            capturePrefix = argv[++i];
+        }
+        else if (arg == "--capture-raw")
+        {
+            captureFormat = FrameCapture::Format::Raw;
+        }
+    }
+
+    if (offscreenFrames > 0)
+    {
+        OffscreenOptions offscreen;
+        offscreen.frameCnt = offscreenFrames;
+        offscreen.dumpPrefix = dumpPrefix;
+        offscreen.workerCnt = workerCnt;
+        mmk.reset(new Memake(k_screenW, k_screenH, offscreen));
+    }
+    else
+    {
+        mmk.reset(new Memake(k_screenW, k_screenH, "memake", windowOptions));
+        mmk->setRenderThread(renderThread);
+        std::cout << "renderer: " << mmk->getRendererName() << std::endl;
+    }
+
+    mmk->setSoftwareRaster(tileRaster);
+    mmk->setStatsOverlay(statsOverlay);
+    if (!statsLogPath.empty() && !mmk->setStatsLog(statsLogPath))
+    {
+        std::cerr << "Can't write statistics to " << statsLogPath << std::endl;
+    }
+    if (!capturePrefix.empty())
+    {
+        mmk->setFrameCapture(capturePrefix, captureFormat);
+    }
+
+    std::unique_ptr<ClRaster> frameRaster;
+    if (clRaster)
+    {
+        initializeDevice(deviceType);
+        std::ifstream rasterFile("../../../raster.cl");
+        const std::string rasterSrc((std::istreambuf_iterator<char>(rasterFile)), std::istreambuf_iterator<char>());
+        frameRaster.reset(new ClRaster(context, device, rasterSrc));
+        if (frameRaster->isReady())
+        {
+            mmk->setRasterizer(frameRaster.get());
+        }
+    }
+
+    std::unique_ptr<WorkerPool> pool;
+    std::unique_ptr<BallRaster> raster;
+    if (softRaster)
+    {
+        pool.reset(new WorkerPool());
+        raster.reset(new BallRaster(*pool));
+    }
+
+    if (!replayPath.empty())
+    {
+        return replay(replayPath, raster.get());
+    }
+
+    const int numOfBall = 4000;
+    vector<Ball> b1;
+    b1.reserve(numOfBall);
+    int sW = worldW;
+    float r = 3;
+    float d = 2 * r;
+    int col = 0;
+    int row = 0;
+    for (int i = 0; i < numOfBall; i++)
+    {
+        int x = col * 1.5 * d + 0.75 * d;
+        int y = row * 1.5 * d + 0.75 * d;
+        b1.push_back(Ball(x, y, r, random_f(0.f, k_PI * 2.f), i));
+        if ((x + 1.5 * d) > sW)
+        {
+            col = 0;
+            row++;
+        }
+        else
+        {
+            col++;
+        }
+    }
+
+    std::vector<BorderLine> lines;
+    lines.push_back({ {0, 400}, {300, 500} });
+    lines.push_back({ {300, 500}, {400, 600} });
+    lines.push_back({ {400, 600}, {450, 700} });
+    lines.push_back({ {1023, 400}, {723, 500} });
+    lines.push_back({ {723, 500}, {623, 600} });
+    lines.push_back({ {623, 600}, {573, 700} });
+
+    if (!cpuSim)
+    {
+        // Initialize OpenCL device.
+        initializeDevice(deviceType);
+        // ball count, border lines and world size don't change during the run
+        selectKernelVariant({ numOfBall, (int)lines.size(), worldW, worldH });
+    }
+
+    long long frameCnt = 0;
+    auto t_start = std::chrono::high_resolution_clock::now();
+    auto curTime = t_start;
+    double frameTimeMs = 0;
+    vector<Ball> b2(numOfBall);
+    Ball* b = &b1[0];
+    Ball* tmpB = &b2[0];
+    BorderLine* bLine = &lines[0];
+    const float maxR = getMaxRadius(b, numOfBall);
+    UniformGrid grid;
+    grid.init(worldW, worldH, k_gridCellSize);
+    // collision grid, cells a few balls wide
+    IncrementalGrid collGrid;
+    collGrid.init(worldW, worldH, std::max(4.f * maxR, 1.f));
+    collGrid.update(numOfBall, [&](int i) { return b[i].pos; });
+
+    // balls and lines don't overlap in a way that needs submission order
+    mmk->setDeferredDrawing(true, true);
+
+    SimRecorder recorder;
+    if (!recordPath.empty() && !recorder.open(recordPath, numOfBall * sizeof(Ball), recordStep, recordDelta))
+    {
+        std::cerr << "Can't record to " << recordPath << std::endl;
+    }
+
+    mmk->update( [&]() 
+    {
+        camera.update(mmk->getDeltaTime());
+        if (cpuSim)
+        {
+            colladeAndUpdateCPUGrid(b, tmpB, numOfBall, maxR, bLine, lines.size(), collGrid, frameTimeMs);
+            // balls moved a fraction of a cell, so only few of them change cells
+            collGrid.update(numOfBall, [&](int i) { return tmpB[i].pos; });
+            drawVisible(tmpB, numOfBall, maxR, bLine, lines.size(), collGrid, raster.get());
+        }
+        else
+        {
+            colladeAndUpdateGPU(b, tmpB, numOfBall, bLine, lines.size(), (float)frameTimeMs);
+            grid.build(numOfBall, [&](int i) { return tmpB[i].pos; });
+            drawVisible(tmpB, numOfBall, maxR, bLine, lines.size(), grid, raster.get());
+        }
+
+        swap(b, tmpB);
+        recorder.submit(frameCnt, b);
+        
+        auto oldTime = curTime;
+        curTime = std::chrono::high_resolution_clock::now();
+        frameTimeMs = std::chrono::duration<double, std::milli>(curTime - oldTime).count();
+
+        frameCnt++;
+        //mmk->delay(100);
+    });
+
+    auto t_end = std::chrono::high_resolution_clock::now();
+    auto timeMs = std::chrono::duration<double, std::milli>(t_end - t_start).count();
+    auto fps = frameCnt * 1000 / timeMs;
+    std::cout << "fps: " << fps << std::endl;
+    mmk->printFrameJitter();
+
+    if (recorder.isOpen())
+    {
+        recorder.close();
+        std::cout << "recording dropped frames: " << recorder.getDroppedCnt() << std::endl;
+        if (recorder.hasWriteFailed())
+        {
+            std::cerr << "recording write failed, " << recordPath << " is incomplete" << std::endl;
+        }
+    }
+    if (mmk->getFrameCapture().isActive())
+    {
+        std::cout << "captured frames: " << mmk->getFrameCapture().getCapturedCnt()
+                  << ", dropped: " << mmk->getFrameCapture().getDroppedCnt() << std::endl;
+    }
+
+    return 0;
 }
\ No newline at end of file
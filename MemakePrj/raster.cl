@@ -0,0 +1,139 @@
+// Tiled rasterizer of Memake draw lists, see ClRaster.h.
+// The frame buffer holds the primitives, 8 ints each, followed by ellipse
+// half width tables, polygon vertices, tile offsets and the primitive ids
+// of every tile. Coverage and blending are integer only and give the same
+// pixels as Memake's span fills and blendSpan32.
+
+#define TILE_SIZE 16
+#define PRIM_INTS 8
+
+#define PRIM_RECT 0
+#define PRIM_ELLIPSE 1
+#define PRIM_POLYGON 2
+#define PRIM_POLKADOT 3
+
+// 16.16 fixed point to pixel, rounded like SDL2_gfx
+int roundFixed(int x)
+{
+    return (x >> 16) + ((x & 32768) >> 15);
+}
+
+// Same pixels as filledPolygonSpans without sorting: on scanline y the sorted
+// intersections k, k + 1 (k even) fill [round(x[k] + 1), round(x[k + 1] - 1)].
+// Rounding keeps the order, so the first a intersections start at or left of
+// px and the first b end left of it. px is covered when some even k < a has
+// k + 1 >= b.
+int polygonCovers(__global const int* v, int n, int maxy, int px, int y)
+{
+    int a = 0;
+    int b = 0;
+    int cnt = 0;
+    for (int i = 0; i < n; i++)
+    {
+        int j = i ? i - 1 : n - 1;
+        int x1 = v[2 * j];
+        int y1 = v[2 * j + 1];
+        int x2 = v[2 * i];
+        int y2 = v[2 * i + 1];
+        if (y1 == y2)
+        {
+            continue;
+        }
+        if (y1 > y2)
+        {
+            int t = x1; x1 = x2; x2 = t;
+            t = y1; y1 = y2; y2 = t;
+        }
+        int yEnd = y2 == maxy ? y2 : y2 - 1;
+        if (y < y1 || y > yEnd)
+        {
+            continue;
+        }
+        int x = ((65536 * (y - y1)) / (y2 - y1)) * (x2 - x1) + 65536 * x1;
+        cnt++;
+        a += roundFixed(x + 1) <= px ? 1 : 0;
+        b += roundFixed(x - 1) < px ? 1 : 0;
+    }
+    // even k in [b - 1, a - 1] with a partner k + 1 < cnt
+    int lo = b > 0 ? b - 1 : 0;
+    int hi = a - 1 < cnt - 2 ? a - 1 : cnt - 2;
+    return lo <= hi && ((lo & 1) == 0 || lo + 1 <= hi);
+}
+
+// dst = src * a + dst * (1 - a), x / 255 as (x + 1 + (x >> 8)) >> 8
+uint blend(uint dst, uint color)
+{
+    uint a = color >> 24;
+    uint ia = 255 - a;
+    uint r = (dst >> 16 & 0xFF) * ia + (color >> 16 & 0xFF) * a;
+    uint g = (dst >> 8 & 0xFF) * ia + (color >> 8 & 0xFF) * a;
+    uint b = (dst & 0xFF) * ia + (color & 0xFF) * a;
+    uint al = (dst >> 24) * ia + 255 * a;
+    r = (r + 1 + (r >> 8)) >> 8;
+    g = (g + 1 + (g >> 8)) >> 8;
+    b = (b + 1 + (b >> 8)) >> 8;
+    al = (al + 1 + (al >> 8)) >> 8;
+    return (al << 24) | (r << 16) | (g << 8) | b;
+}
+
+// One work-group per tile, one work-item per pixel. Primitives of the tile
+// are drawn in submission order, so the result is the same on any device.
+__kernel void rasterTiles(__global const int* frame, int tileOffsets, int tileIds, int tilesX,
+                          int w, int h, int clear, uint bgColor, __global uint* pixels)
+{
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+    if (x >= w || y >= h)
+    {
+        return;
+    }
+
+    int tile = get_group_id(1) * tilesX + get_group_id(0);
+    uint dst = clear ? bgColor : pixels[y * w + x];
+    int beg = frame[tileOffsets + tile];
+    int end = frame[tileOffsets + tile + 1];
+    for (int i = beg; i < end; i++)
+    {
+        __global const int* p = frame + PRIM_INTS * frame[tileIds + i];
+        int type = p[0];
+        uint color = (uint)p[1];
+        int covered = 0;
+        if (type == PRIM_RECT)
+        {
+            covered = x >= p[2] && x < p[2] + p[4] && y >= p[3] && y < p[3] + p[5];
+        }
+        else if (type == PRIM_ELLIPSE)
+        {
+            int row = y - p[3];
+            if (row >= -p[5] && row <= p[5])
+            {
+                int hw = frame[p[6] + row + p[5]];
+                int dx = x - p[2];
+                covered = dx >= -hw && dx <= hw;
+            }
+        }
+        else if (type == PRIM_POLYGON)
+        {
+            covered = x >= p[2] && x <= p[4] && y >= p[3] && y <= p[5] &&
+                polygonCovers(frame + p[6], p[7], p[5], x, y);
+        }
+        else if (type == PRIM_POLKADOT)
+        {
+            if (x >= p[2] && x < p[4] && y >= p[3] && y < p[5])
+            {
+                // squared distances to (25, 25), (50, 50) and (75, 75), low byte
+                uint r = (uint)((x - 25) * (x - 25) + (y - 25) * (y - 25)) & 0xFF;
+                uint g = (uint)((x - 50) * (x - 50) + (y - 50) * (y - 50)) & 0xFF;
+                uint b = (uint)((x - 75) * (x - 75) + (y - 75) * (y - 75)) & 0xFF;
+                dst = 0xFF000000 | (r << 16) | (g << 8) | b;
+            }
+            continue;
+        }
+
+        if (covered)
+        {
+            dst = (color >> 24) == 0xFF ? color : blend(dst, color);
+        }
+    }
+    pixels[y * w + x] = dst;
+}